@@ -14,19 +14,36 @@ using etl::data::RangePtr;
 
 namespace vga {
 
-extern "C" {
-  extern uint8_t _ccm_arena_start, _ccm_arena_end;
-  extern uint8_t _sram112_arena_start, _sram112_arena_end;
-}
-
 using Arena = etl::mem::Arena<
   etl::mem::ReturnNullptrOnAllocationFailure,
   etl::mem::DoNotRequireDeallocation
 >;
 
+#ifdef VGA_HOST_SIM
+
+// The host simulator has no linker script to place the arenas for us, so we
+// provide ordinary memory of about the same size as the real thing.
+static uint8_t ccm_arena_storage[64 * 1024];
+static uint8_t sram112_arena_storage[112 * 1024];
+
+static Arena ccm_arena({ccm_arena_storage,
+                        ccm_arena_storage + sizeof(ccm_arena_storage)});
+static Arena sram112_arena({sram112_arena_storage,
+                            sram112_arena_storage
+                                + sizeof(sram112_arena_storage)});
+
+#else
+
+extern "C" {
+  extern uint8_t _ccm_arena_start, _ccm_arena_end;
+  extern uint8_t _sram112_arena_start, _sram112_arena_end;
+}
+
 static Arena ccm_arena({&_ccm_arena_start, &_ccm_arena_end});
 static Arena sram112_arena({&_sram112_arena_start, &_sram112_arena_end});
 
+#endif
+
 /*
  * This serves as a *prioritized* search list, so allocations will be made from
  * the first arena that fits.  We prioritize CCM over the SRAM112 bank because
@@ -0,0 +1,122 @@
+#ifndef VGA_BACKEND_H
+#define VGA_BACKEND_H
+
+#include <cstdint>
+
+#include "etl/attribute_macros.h"
+
+#include "vga/rasterizer.h"
+
+/*
+ * The seam between the portable parts of the driver (vga.cc) and the code that
+ * actually produces a video signal.  Applications don't need this header.
+ *
+ * The driver core thinks about every scanline in terms of three events, which
+ * occur in this order:
+ *
+ *  - Start of active video (SAV), when scanout of the line's pixels begins.
+ *  - End of active video (EAV), which advances the vertical state machine,
+ *    prepares the scanout machinery for the next line, and pends hblank work.
+ *  - Hblank work, which runs at lower priority than the other two and
+ *    rasterizes upcoming lines.
+ *
+ * On the STM32F4 (backend_stm32f4.cc) these events are interrupts generated by
+ * timers.  In the host simulator (sim.cc) they're function calls made by a
+ * simulated line clock.
+ */
+
+// Placement of driver state and code.  On the host these are merely named
+// sections; on the STM32F4 the linker script maps them to particular RAMs.
+#define IN_SCAN_RAM ETL_SECTION(".vga_scan_ram")
+#define IN_LOCAL_RAM ETL_SECTION(".vga_local_ram")
+
+#define RAM_CODE ETL_SECTION(".ramcode")
+
+namespace vga {
+
+struct Timing;  // see: timing.h
+
+/*******************************************************************************
+ * Event handlers implemented by the driver core, for use by the backend.
+ */
+
+void start_of_active_video();
+void end_of_active_video();
+void hblank_work();
+
+namespace backend {
+
+/*******************************************************************************
+ * Operations implemented by the backend, for use by the driver core.
+ *
+ * The public functions sync_on, sync_off, video_on, and video_off (from vga.h)
+ * are purely a matter of hardware, so each backend implements them directly.
+ */
+
+/*
+ * Performs one-time setup of the hardware, e.g. clocks and interrupt
+ * priorities.  Called from vga::init.
+ */
+void init();
+
+/*
+ * Stops the line clock and waits for any scanout in progress to finish.  On
+ * return, no more events will be delivered until start_timing.
+ */
+void stop_timing();
+
+/*
+ * Configures the line clock for the given timing, but does not start it.
+ */
+void configure_timing(Timing const &);
+
+/*
+ * Starts delivering events according to the last configured timing.
+ */
+void start_timing();
+
+/*
+ * Configures (but does not start) the scanout of a line described by 'shape'
+ * from 'pixels', which is followed by at least one word of blank pixels.
+ * This includes positioning the next SAV event according to shape.offset.
+ * Called at EAV, after end_scanout, for each line to be displayed.
+ */
+void prepare_scanout(Rasterizer::Pixel const *pixels,
+                     Rasterizer::RasterInfo const &shape);
+
+/*
+ * Starts the scanout prepared by prepare_scanout.  Called at SAV.
+ */
+void start_scanout();
+
+/*
+ * Stops any scanout in progress.  Called at EAV.
+ */
+void end_scanout();
+
+/*
+ * Arranges for hblank_work to be called once the current event handler
+ * returns.
+ */
+void pend_hblank_work();
+
+/*
+ * Toggles the vertical sync output.
+ */
+void toggle_vsync();
+
+/*
+ * Returns a free-running count of CPU cycles, for deadline monitoring.  The
+ * difference of two readings is meaningful across wraparound.
+ */
+std::uint32_t cycle_count();
+
+/*
+ * Idles the calling thread until at least one event has been delivered.
+ */
+void idle();
+
+}  // namespace backend
+}  // namespace vga
+
+#endif  // VGA_BACKEND_H
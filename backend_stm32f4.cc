@@ -0,0 +1,500 @@
+#include "vga/backend.h"
+
+#include <cstdint>
+
+#include "etl/assert.h"
+#include "etl/attribute_macros.h"
+#include "etl/prediction.h"
+
+#include "etl/armv7m/exceptions.h"
+#include "etl/armv7m/exception_table.h"
+#include "etl/armv7m/instructions.h"
+#include "etl/armv7m/scb.h"
+#include "etl/armv7m/types.h"
+
+#include "etl/stm32f4xx/adv_timer.h"
+#include "etl/stm32f4xx/ahb.h"
+#include "etl/stm32f4xx/apb.h"
+#include "etl/stm32f4xx/dbg.h"
+#include "etl/stm32f4xx/dma.h"
+#include "etl/stm32f4xx/flash.h"
+#include "etl/stm32f4xx/gpio.h"
+#include "etl/stm32f4xx/gp_timer.h"
+#include "etl/stm32f4xx/interrupts.h"
+#include "etl/stm32f4xx/interrupt_table.h"
+#include "etl/stm32f4xx/rcc.h"
+#include "etl/stm32f4xx/syscfg.h"
+
+#include "vga/measurement.h"
+#include "vga/rasterizer.h"
+#include "vga/timing.h"
+#include "vga/vga.h"
+
+using etl::armv7m::Byte;
+using etl::armv7m::HalfWord;
+using etl::armv7m::scb;
+using etl::armv7m::Scb;
+using etl::armv7m::Word;
+
+using etl::stm32f4xx::AdvTimer;
+using etl::stm32f4xx::AhbPeripheral;
+using etl::stm32f4xx::ApbPeripheral;
+using etl::stm32f4xx::dbg;
+using etl::stm32f4xx::Dbg;
+using etl::stm32f4xx::Dma;
+using etl::stm32f4xx::dma2;
+using etl::stm32f4xx::flash;
+using etl::stm32f4xx::Gpio;
+using etl::stm32f4xx::gpiob;
+using etl::stm32f4xx::gpioe;
+using etl::stm32f4xx::GpTimer;
+using etl::stm32f4xx::Interrupt;
+using etl::stm32f4xx::rcc;
+using etl::stm32f4xx::syscfg;
+using etl::stm32f4xx::tim1;
+using etl::stm32f4xx::tim3;
+using etl::stm32f4xx::tim4;
+
+namespace vga {
+
+/*******************************************************************************
+ * Backend configuration.
+ */
+
+static constexpr unsigned
+  // Fudge factor: shifts timer-initiated DRQ back in time by this many cycles,
+  // to delay DRQ until DMA has started.
+  drq_shift_cycles = 2,
+  // Fudge factor: how long the shock absorber IRQ should lead the actual start
+  // of video IRQ, in cycles.
+  shock_absorber_shift_cycles = 20;
+
+// Common fields used in scanout DMA transfer settings.
+static constexpr auto dma_xfer_common = Dma::Stream::cr_value_t()
+  .with_chsel(6)  // for TIM1_UP
+  .with_pl(Dma::Stream::cr_value_t::pl_t::very_high)
+  .with_pburst(Dma::Stream::BurstSize::single)
+  .with_mburst(Dma::Stream::BurstSize::single)
+  .with_en(true);
+
+
+/*******************************************************************************
+ * Backend state.
+ */
+
+// A pre-built control register word to be used to start the next DMA transfer.
+// This is set up during hblank based on the shape of the line to be scanned
+// out, and consumed at start of active video.
+static Dma::Stream::cr_value_t next_dma_xfer;
+IN_LOCAL_RAM
+static bool next_use_timer;
+
+// TIM4 CCR2 value that produces SAV at the default position, in pixels.  We
+// apply each rasterizer's requested offset to this in prepare_scanout.
+static unsigned sav_pixels;
+
+
+/*******************************************************************************
+ * Public API that is purely a matter of hardware.
+ */
+
+void sync_off() {
+  gpiob.set_mode((1 << 6) | (1 << 7), Gpio::Mode::input);
+  gpiob.set_pull((1 << 6) | (1 << 7), Gpio::Pull::down);
+}
+
+void video_off() {
+  gpioe.set_mode(0xFF00, Gpio::Mode::input);
+  gpioe.set_pull(0xFF00, Gpio::Pull::down);
+}
+
+void sync_on() {
+  // Configure PB6 to produce hsync using TIM4_CH1
+  gpiob.set_alternate_function(Gpio::p6, 2);
+  gpiob.set_output_type(Gpio::p6, Gpio::OutputType::push_pull);
+  gpiob.set_output_speed(Gpio::p6, Gpio::OutputSpeed::fast_50mhz);
+  gpiob.set_mode(Gpio::p6, Gpio::Mode::alternate);
+
+  // Configure PB7 as GPIO output.
+  gpiob.set_output_type(Gpio::p7, Gpio::OutputType::push_pull);
+  gpiob.set_output_speed(Gpio::p7, Gpio::OutputSpeed::fast_50mhz);
+  gpiob.set_mode(Gpio::p7, Gpio::Mode::gpio);
+}
+
+void video_on() {
+  // Configure the high byte of port E for parallel video.
+  // Using 100MHz output speed gets slightly sharper transitions than 50MHz.
+  gpioe.set_output_type(0xFF00, Gpio::OutputType::push_pull);
+  gpioe.set_output_speed(0xFF00, Gpio::OutputSpeed::high_100mhz);
+  gpioe.set_mode(0xFF00, Gpio::Mode::gpio);
+}
+
+
+namespace backend {
+
+/*******************************************************************************
+ * Setup and timing configuration.
+ */
+
+void init() {
+  // Turn on I/O compensation cell to reduce noise on power supply.
+  rcc.enable_clock(ApbPeripheral::syscfg);
+  syscfg.write_cmpcr(syscfg.read_cmpcr().with_cmp_pd(true));
+
+  // Start the cycle counter used for deadline monitoring.
+  mcyc_init();
+
+  // Turn a bunch of stuff on.
+  rcc.enable_clock(AhbPeripheral::gpiob);  // Sync signals
+  rcc.enable_clock(AhbPeripheral::gpioe);  // Video
+  rcc.enable_clock(AhbPeripheral::dma2);
+
+  auto &st = dma2.stream5;
+
+  // DMA configuration
+
+  // Configure FIFO.
+  st.write_fcr(Dma::Stream::fcr_value_t()
+               .with_fth(Dma::Stream::fcr_value_t::fth_t::quarter)
+               .with_dmdis(true)
+               .with_feie(false));
+
+  // Configure the pixel-generation timer used during reduced-horizontal mode.
+  // We use TIM1; it's an APB2 (fast) peripheral, and with our clock config
+  // it gets clocked at the full CPU rate.  We'll load ARR under rasterizer
+  // control to synthesize 1/n rates.
+  rcc.enable_clock(ApbPeripheral::tim1);
+  tim1.write_psc(1 - 1);  // Divide input clock by 1.
+  tim1.write_cr1(AdvTimer::cr1_value_t()
+      .with_urs(true));
+  tim1.write_dier(AdvTimer::dier_value_t()
+      .with_ude(true));  // DRQ on update
+
+  // Configure our interrupt priorities.  The scheme is:
+  //  TIM4 (horizontal) gets highest priority.
+  //  TIM3 (shock absorber) is set just lower.
+  //  PendSV (rendering, user code) is lowest.
+  // We could fit other stuff into the gaps later.
+  // Note that PendSV is set using ARMv7-M priorities (0-255) and the others are
+  // set using narrower SoC priorities (0-15).  This is a bit ugly.
+  set_irq_priority(Interrupt::tim4, 0);
+  set_irq_priority(Interrupt::tim3, 1);
+  scb.set_exception_priority(etl::armv7m::Exception::pend_sv, 0xFF);
+
+  // Halt all our timers on debug.
+  dbg.write_dbgmcu_apb1_fz(dbg.read_dbgmcu_apb1_fz()
+                           .with_dbg_tim4_stop(true)
+                           .with_dbg_tim3_stop(true));
+
+  dbg.write_dbgmcu_apb2_fz(dbg.read_dbgmcu_apb2_fz()
+                           .with_dbg_tim1_stop(true));
+
+  // Enable Flash cache and prefetching to try and reduce jitter.
+  // This only affects best-effort-level code, not anything realtime.
+  flash.write_acr(flash.read_acr()
+                  .with_dcen(true)
+                  .with_icen(true)
+                  .with_prften(true));
+}
+
+/*
+ * Sets up one of the two horizontal timers, which share almost all of their
+ * init code.
+ */
+static void configure_h_timer(Timing const &timing,
+                              ApbPeripheral p,
+                              GpTimer &tim) {
+  rcc.enable_clock(p);
+  rcc.leave_reset(p);
+
+  // Configure the timer to count in pixels.  These timers live on APB1.
+  // Like all APB timers they get their clocks doubled at certain APB
+  // multipliers.
+  auto apb_cycles_per_pixel = timing.clock_config.apb1_divisor > 1
+      ? (timing.cycles_per_pixel * 2 / timing.clock_config.apb1_divisor)
+      : timing.cycles_per_pixel;
+
+  tim.write_psc(apb_cycles_per_pixel - 1);
+
+  tim.write_arr(timing.line_pixels - 1);
+  tim.write_ccr1(timing.sync_pixels);
+  tim.write_ccr2(timing.sync_pixels
+                 + timing.back_porch_pixels - timing.video_lead);
+  tim.write_ccr3(timing.sync_pixels
+                 + timing.back_porch_pixels + timing.video_pixels);
+
+  tim.write_ccmr1(GpTimer::ccmr1_value_t()
+                  .with_oc1m(GpTimer::OcMode::pwm1)
+                  .with_cc1s(GpTimer::ccmr1_value_t::cc1s_t::output));
+
+  tim.write_ccer(GpTimer::ccer_value_t()
+                 .with_cc1e(true)
+                 .with_cc1p(
+                     timing.hsync_polarity == Timing::Polarity::negative));
+
+}
+
+/*
+ * Safely shut down a timer, so that we can reconfigure without interlocks.
+ */
+static void disable_h_timer(ApbPeripheral p,
+                            Interrupt irq) {
+  // Ensure that we'll receive no further interrupts.
+  disable_irq(irq);
+  // Ensure that the peripheral will generate no further interrupts.
+  rcc.enter_reset(p);
+  // In case of race condition between the above actions, clear any pending.
+  clear_pending_irq(irq);
+}
+
+void stop_timing() {
+  // Place the horizontal timers in reset, disabling interrupts.
+  disable_h_timer(ApbPeripheral::tim4, Interrupt::tim4);
+  disable_h_timer(ApbPeripheral::tim3, Interrupt::tim3);
+
+  // Busy-wait for pending DMA to complete.
+  while (dma2.stream5.read_cr().get_en());
+}
+
+void configure_timing(Timing const &timing) {
+  // No scanout strategy can achieve fewer than 4 cycles per pixel.
+  ETL_ASSERT(timing.cycles_per_pixel >= 4);
+  // Because horizontal timing is managed by timers on the slower APB1 bus,
+  // make sure that we can express the (AHB) cycles_per_pixel in APB1 units.
+  if (timing.clock_config.apb1_divisor > 1) {
+    ETL_ASSERT(timing.cycles_per_pixel % (timing.clock_config.apb1_divisor / 2)
+                  == 0);
+  }
+
+  // Switch to new CPU clock settings.
+  rcc.configure_clocks(timing.clock_config);
+
+  // Configure TIM3/4 for horizontal sync generation.
+  configure_h_timer(timing, ApbPeripheral::tim3, tim3);
+  configure_h_timer(timing, ApbPeripheral::tim4, tim4);
+
+  // Adjust tim3's CC2 value back in time.
+  tim3.write_ccr2(Word(tim3.read_ccr2()) - shock_absorber_shift_cycles);
+
+  // Configure tim3 to distribute its enable signal as its trigger output.
+  tim3.write_cr2(GpTimer::cr2_value_t()
+                 .with_mms(GpTimer::cr2_value_t::mms_t::enable)
+                 .with_ccds(false));
+
+  // Configure tim4 to trigger from tim3 and run forever.
+  tim4.write_smcr(GpTimer::smcr_value_t()
+                  .with_ts(GpTimer::smcr_value_t::ts_t::itr2)
+                  .with_sms(GpTimer::smcr_value_t::sms_t::trigger));
+
+  // Turn on tim4's interrupts.
+  tim4.write_dier(GpTimer::dier_value_t()
+                  .with_cc2ie(true)    // Interrupt at start of active video.
+                  .with_cc3ie(true));  // Interrupt at end of active video.
+
+  // Turn on only one of tim3's
+  tim3.write_dier(GpTimer::dier_value_t()
+                  .with_cc2ie(true));  // Interrupt at start of active video.
+
+  // Note: timers still not running.
+
+  switch (timing.vsync_polarity) {
+    case Timing::Polarity::positive: gpiob.clear(1 << 7); break;
+    case Timing::Polarity::negative: gpiob.set  (1 << 7); break;
+  }
+
+  sav_pixels = timing.sync_pixels
+             + timing.back_porch_pixels - timing.video_lead;
+  next_use_timer = false;
+}
+
+void start_timing() {
+  // Start TIM3, which starts TIM4.
+  enable_irq(Interrupt::tim3);
+  enable_irq(Interrupt::tim4);
+  tim3.write_cr1(tim3.read_cr1().with_cen(true));
+}
+
+
+/*******************************************************************************
+ * Per-line events.
+ */
+
+RAM_CODE
+void start_scanout() {
+  // Clear stream 5 flags (hifcr is a write-1-to-clear register).
+  dma2.write_hifcr(Dma::hifcr_value_t()
+                   .with_cdmeif5(true)
+                   .with_cteif5(true)
+                   .with_chtif5(true)
+                   .with_ctcif5(true));
+
+  // Start the countdown for first DRQ.
+  tim1.write_cr1(AdvTimer::cr1_value_t()
+      .with_urs(true)
+      .with_cen(next_use_timer));
+
+  dma2.stream5.write_cr(next_dma_xfer);
+}
+
+RAM_CODE
+void end_scanout() {
+  // Shut off TIM1; only really matters in reduced-horizontal mode.
+  tim1.write_cr1(AdvTimer::cr1_value_t()
+      .with_urs(true)
+      .with_cen(false));
+}
+
+/*
+ * Prepares a configuration for the DMA stream and configures the horizontal
+ * timer, if it's relevant to this mode.
+ */
+RAM_CODE
+void prepare_scanout(Rasterizer::Pixel const *pixels,
+                     Rasterizer::RasterInfo const &shape) {
+  auto & st = dma2.stream5;
+  st.write_cr(st.read_cr().with_en(false));
+
+  if (shape.cycles_per_pixel > 4) {
+    // Adjust reload frequency of TIM1 to accomodate desired pixel clock.
+    // (ARR value is period - 1.)
+    tim1.write_arr(shape.cycles_per_pixel - 1);
+    // Force an update to reset the timer state.
+    tim1.write_egr(AdvTimer::egr_value_t().with_ug(true));
+    // Configure the timer as *almost* ready to produce a DRQ, less a small
+    // value (fudge factor).  Gotta do this after the update event, above,
+    // because that clears CNT.
+    tim1.write_cnt(uint32_t(tim1.read_arr()) - drq_shift_cycles);
+    tim1.write_sr(0);
+
+    st.write_par(0x40021015);  // High byte of GPIOE ODR (hack hack)
+    st.write_m0ar(reinterpret_cast<Word>(pixels));
+
+    // The number of bytes read must exactly match the number of bytes written,
+    // or the DMA controller will freak out.  Thus, we must adapt the transfer
+    // size to the number of bytes transferred.
+    Dma::Stream::TransferSize msize;
+    switch (shape.length & 3) {
+      case 0:
+        msize = Dma::Stream::TransferSize::word;
+        st.write_ndtr(shape.length + sizeof(Word));
+        break;
+
+      case 2:
+        msize = Dma::Stream::TransferSize::half_word;
+        st.write_ndtr(shape.length + sizeof(HalfWord));
+        break;
+
+      default:
+        msize = Dma::Stream::TransferSize::byte;
+        st.write_ndtr(shape.length + sizeof(Byte));
+        break;
+    }
+
+    next_dma_xfer = dma_xfer_common
+        .with_dir(Dma::Stream::cr_value_t::dir_t::memory_to_peripheral)
+        .with_msize(msize)
+        .with_minc(true)
+        .with_psize(Dma::Stream::TransferSize::byte)
+        .with_pinc(false);
+    next_use_timer = true;
+
+  } else {
+    // Note that we're using memory as the peripheral side.
+    // This DMA controller is a little odd.
+    st.write_par(reinterpret_cast<Word>(pixels));
+    st.write_m0ar(0x40021015);  // High byte of GPIOE ODR (hack hack)
+
+    Dma::Stream::TransferSize psize;
+    switch (shape.length & 3) {
+      case 0:
+        psize = Dma::Stream::TransferSize::word;
+        st.write_ndtr(shape.length / sizeof(Word) + 1);
+        break;
+
+      case 2:
+        psize = Dma::Stream::TransferSize::half_word;
+        st.write_ndtr(shape.length / sizeof(HalfWord) + 1);
+        break;
+
+      default:
+        psize = Dma::Stream::TransferSize::byte;
+        st.write_ndtr(shape.length / sizeof(Byte) + 1);
+        break;
+    }
+
+    next_dma_xfer = dma_xfer_common
+        .with_dir(Dma::Stream::cr_value_t::dir_t::memory_to_memory)
+        .with_psize(psize)
+        .with_pinc(true)
+        .with_msize(Dma::Stream::TransferSize::byte)
+        .with_minc(false);
+    next_use_timer = false;
+  }
+
+  // Apply timing changes requested by the rasterizer.
+  tim4.write_ccr2(sav_pixels + shape.offset);
+}
+
+RAM_CODE
+void pend_hblank_work() {
+  // Hblank work runs as PendSV.
+  scb.write_icsr(Scb::icsr_value_t().with_pendsvset(true));
+}
+
+RAM_CODE
+void toggle_vsync() {
+  gpiob.toggle(Gpio::p7);
+}
+
+RAM_CODE
+std::uint32_t cycle_count() {
+  return mcyc_get();
+}
+
+void idle() {
+  etl::armv7m::wait_for_interrupt();
+}
+
+}  // namespace backend
+}  // namespace vga
+
+
+/*******************************************************************************
+ * ISRs
+ */
+
+RAM_CODE void etl_stm32f4xx_tim3_handler() {
+  // We access this APB2 timer through the bridge on AHB1.  This implies
+  // both wait states and resource conflicts with scanout.  Get done fast.
+  tim3.write_sr(tim3.read_sr().with_cc2if(false));
+
+  // Idle the processor until preempted by any higher-priority interrupt.
+  // This ensures that the M4's D-code bus is available for exception entry.
+  // NOTE: this behaves correctly on the M4, but WFI is not guaranteed to
+  // actually do anything.
+  etl::armv7m::wait_for_interrupt();
+}
+
+RAM_CODE void etl_stm32f4xx_tim4_handler() {
+  // We have to clear our interrupt flags, or this will recur.
+  auto sr = tim4.read_sr();
+
+  if (ETL_LIKELY(sr.get_cc2if())) {
+    tim4.write_sr(sr.with_cc2if(false));
+    vga::start_of_active_video();
+    return;
+  }
+
+  if (sr.get_cc3if()) {
+    tim4.write_sr(sr.with_cc3if(false));
+    vga::end_of_active_video();
+    return;
+  }
+}
+
+RAM_CODE
+void etl_armv7m_pend_sv_handler() {
+  // PendSV event is triggered shortly after EAV to process lower-priority
+  // tasks.  See vga::hblank_work.
+  vga::hblank_work();
+}
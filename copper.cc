@@ -0,0 +1,49 @@
+#include "vga/copper.h"
+
+#include "etl/assert.h"
+
+#include "vga/arena.h"
+
+namespace vga {
+
+CopperList::CopperList(unsigned capacity)
+  : _capacity(capacity),
+    _bg_count(0),
+    _pages{arena_new_array<CopperOp>(capacity + 1),
+           arena_new_array<CopperOp>(capacity + 1)},
+    _page1{false},
+    _flip_pended{false} {
+  _pages[0][0] = CopperOp::end();
+  _pages[1][0] = CopperOp::end();
+}
+
+void CopperList::clear() {
+  _bg_count = 0;
+  _pages[!_page1][0] = CopperOp::end();
+}
+
+void CopperList::add(CopperOp const &op) {
+  ETL_ASSERT(_bg_count < _capacity);
+
+  auto page = _pages[!_page1];
+  ETL_ASSERT(_bg_count == 0 || page[_bg_count - 1].line <= op.line);
+
+  page[_bg_count] = op;
+  page[++_bg_count] = CopperOp::end();
+}
+
+void CopperList::pend_flip() {
+  _flip_pended = true;
+}
+
+CopperOp const *CopperList::begin_frame() {
+  if (_flip_pended) {
+    _page1 = !_page1;
+    _bg_count = 0;
+    _pages[!_page1][0] = CopperOp::end();
+    _flip_pended = false;
+  }
+  return _pages[_page1];
+}
+
+}  // namespace vga
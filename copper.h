@@ -0,0 +1,129 @@
+#ifndef VGA_COPPER_H
+#define VGA_COPPER_H
+
+#include <atomic>
+#include <cstdint>
+
+#include "vga/vga.h"
+
+namespace vga {
+
+/*
+ * A single copper operation: an action the driver takes just before it
+ * rasterizes a particular visible line.  This is a cheap way to get raster
+ * effects -- palette changes partway down the screen, horizontal wobble,
+ * switching a Rasterizer's page or scroll position -- without writing a
+ * Rasterizer or a timing-sensitive vga_hblank_interrupt.
+ *
+ * Because the driver rasterizes ahead of scanout, operations run in
+ * rasterization order, not display order: an operation at line N affects the
+ * rasterization of line N and below, but runs while some earlier line is
+ * still on screen.  Any state an operation touches should therefore be read
+ * by Rasterizers, not by the video hardware.
+ *
+ * Operations run in PendSV, interleaved with calls to Rasterizers.
+ */
+struct CopperOp {
+  enum class Kind {
+    write_byte,   // *(uint8_t *) address = value
+    write_word,   // *(uint32_t *) address = value
+    call,         // function(address)
+    set_offset,   // Shift this and later lines right by (int) value pixels.
+    end,
+  };
+
+  unsigned line;
+  Kind kind;
+  void *address;
+  void (*function)(void *);
+  std::uint32_t value;
+
+  static constexpr CopperOp write_byte(unsigned line,
+                                       std::uint8_t *address,
+                                       std::uint8_t value) {
+    return { line, Kind::write_byte, address, nullptr, value };
+  }
+
+  static constexpr CopperOp write_word(unsigned line,
+                                       std::uint32_t *address,
+                                       std::uint32_t value) {
+    return { line, Kind::write_word, address, nullptr, value };
+  }
+
+  static constexpr CopperOp call(unsigned line,
+                                 void (*function)(void *),
+                                 void *arg = nullptr) {
+    return { line, Kind::call, arg, function, 0 };
+  }
+
+  static constexpr CopperOp set_offset(unsigned line, int offset) {
+    return { line, Kind::set_offset, nullptr, nullptr,
+             static_cast<std::uint32_t>(offset) };
+  }
+
+  static constexpr CopperOp end() {
+    return { ~0u, Kind::end, nullptr, nullptr, 0 };
+  }
+};
+
+/*
+ * A double-buffered list of CopperOps.  The application builds the next frame's
+ * operations in the background page while the driver executes the foreground
+ * page, then uses pend_flip to swap them at the top of the next frame.
+ *
+ * The driver's per-line cost for a CopperList is a single comparison, plus
+ * whatever operations actually run.  Lines with operations are always
+ * rasterized individually, even if the Rasterizer asked for them to be
+ * repeated.
+ *
+ * Give a CopperList to the driver with configure_copper_list.
+ */
+class CopperList {
+public:
+  /*
+   * Creates a CopperList with room for 'capacity' operations in each page,
+   * allocated from the arena.  Both pages start out empty.
+   */
+  explicit CopperList(unsigned capacity);
+
+  /*
+   * Empties the background page.
+   */
+  void clear();
+
+  /*
+   * Appends an operation to the background page.  Operations must be added in
+   * order of line number; several operations on the same line run in the
+   * order added.
+   */
+  void add(CopperOp const &);
+
+  /*
+   * Records that the pages should be swapped at the top of the next frame.
+   * Until then (see is_flip_pended) the background page must not be altered.
+   * Once the flip happens, the new background page is empty.
+   */
+  void pend_flip();
+
+  /*
+   * Checks whether a flip requested by pend_flip is still outstanding.
+   */
+  bool is_flip_pended() const { return _flip_pended; }
+
+  /*
+   * Used by the driver at the top of each frame: applies any pended flip and
+   * returns the foreground page, which is terminated by an end operation.
+   */
+  CopperOp const *begin_frame();
+
+private:
+  unsigned _capacity;
+  unsigned _bg_count;
+  CopperOp *_pages[2];
+  bool _page1;
+  std::atomic<bool> _flip_pended;
+};
+
+}  // namespace vga
+
+#endif  // VGA_COPPER_H
@@ -0,0 +1,12 @@
+#include "vga/copy_words.h"
+
+using etl::armv7m::Word;
+
+/*
+ * Portable equivalent of copy_words.S, for targets without the FPU register
+ * file it depends upon -- notably the host simulator.
+ */
+__attribute__((section(".ramcode")))
+void copy_words(Word const *source, Word *dest, Word count) {
+  while (count--) *dest++ = *source++;
+}
@@ -5,6 +5,7 @@
 
 /*
  * Moves some number of aligned words using the fastest method I could think up.
+ * 'count' may be zero.
  */
 void copy_words(etl::armv7m::Word const *source,
                 etl::armv7m::Word *dest,
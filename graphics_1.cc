@@ -1,5 +1,7 @@
 #include "vga/graphics_1.h"
 
+#include <cstdint>
+
 #include "etl/prediction.h"
 #include "etl/utility.h"
 
@@ -32,8 +34,8 @@ unsigned *Graphics1::word_addr(unsigned x, unsigned y) {
 
 RAMCODE("Graphics1.bit_addr")
 unsigned *Graphics1::bit_addr(unsigned x, unsigned y) {
-  unsigned offset = reinterpret_cast<unsigned>(_b.base);
-  unsigned bit_base = offset * 32 + 0x22000000;
+  auto offset = reinterpret_cast<std::uintptr_t>(_b.base);
+  auto bit_base = offset * 32 + 0x22000000;
 
   return reinterpret_cast<unsigned *>(bit_base) + y * _b.width_px + x;
 }
@@ -28,6 +28,12 @@ void msigs_init() {
   gpioe.set_mode(0xFF, Gpio::Mode::gpio);
 }
 
+void mcyc_init() {
+  // DEMCR.TRCENA powers up the DWT; DWT_CTRL.CYCCNTENA starts the counter.
+  *reinterpret_cast<unsigned volatile *>(0xE000EDFC) |= 1 << 24;
+  *reinterpret_cast<unsigned volatile *>(0xE0001000) |= 1 << 0;
+}
+
 void mtim_init() {
   sys_tick.write_rvr(0xFFFFFF);
   sys_tick.write_csr(SysTick::csr_value_t()
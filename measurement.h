@@ -30,6 +30,28 @@ ETL_INLINE unsigned mtim_get() {
   return etl::armv7m::sys_tick.read_cvr().get_current();
 }
 
+/*******************************************************************************
+ * DWT cycle counter profiling support.
+ *
+ * The Data Watchpoint and Trace unit contains a 32-bit cycle counter that
+ * counts up at the CPU clock frequency.  Unlike SysTick, it has a useful range
+ * of tens of seconds, and nothing else in the system expects to own it.  It
+ * can be read without disturbing video.
+ */
+
+/*
+ * Enables the cycle counter.  Safe to call repeatedly.
+ */
+void mcyc_init();
+
+/*
+ * Reads the cycle counter.  This is a 32-bit up counter, so the difference of
+ * two readings is correct across wraparound.
+ */
+ETL_INLINE unsigned mcyc_get() {
+  return *reinterpret_cast<unsigned const volatile *>(0xE0001004);  // CYCCNT
+}
+
 /*******************************************************************************
  * GPIO profiling support.
  *
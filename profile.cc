@@ -0,0 +1,53 @@
+#include "vga/profile.h"
+
+#include "vga/backend.h"
+
+namespace vga {
+namespace profile {
+
+#ifdef VGA_PROFILE
+
+static constexpr unsigned probe_count = unsigned(Probe::count);
+
+static Histogram histograms[max_monitored_bands][probe_count];
+
+Histogram get_histogram(unsigned band_index, Probe probe) {
+  if (band_index >= max_monitored_bands) return {};
+  return histograms[band_index][unsigned(probe)];
+}
+
+void reset() {
+  for (auto &band : histograms) {
+    for (auto &h : band) h = {};
+  }
+}
+
+RAM_CODE
+void record(Probe probe, unsigned band_index, std::uint32_t cycles) {
+  if (band_index >= max_monitored_bands) return;
+  auto &h = histograms[band_index][unsigned(probe)];
+
+  ++h.samples;
+  h.total_cycles += cycles;
+  if (cycles > h.max_cycles) h.max_cycles = cycles;
+
+  // Bucket index is the bit length of the sample.
+  unsigned bucket = cycles ? 32 - __builtin_clz(cycles) : 0;
+  if (bucket >= histogram_buckets) bucket = histogram_buckets - 1;
+  ++h.buckets[bucket];
+}
+
+#else
+
+Histogram get_histogram(unsigned, Probe) {
+  return {};
+}
+
+void reset() {}
+
+void record(Probe, unsigned, std::uint32_t) {}
+
+#endif
+
+}  // namespace profile
+}  // namespace vga
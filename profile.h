@@ -0,0 +1,94 @@
+#ifndef VGA_PROFILE_H
+#define VGA_PROFILE_H
+
+#include <cstdint>
+
+#include "vga/vga.h"
+
+namespace vga {
+namespace profile {
+
+/*
+ * Non-disruptive profiling of the driver's per-line work.
+ *
+ * When the build environment defines VGA_PROFILE, the driver times each of the
+ * operations below using the cycle counter (see mcyc_get in measurement.h) and
+ * files the results into a histogram per operation per Band.  Unlike the GPIO
+ * signals in measurement.h, this doesn't touch the AHB, so it's safe to leave
+ * on while video runs; the cost is a couple of cycle counter reads and a
+ * histogram update per operation.
+ *
+ * Without VGA_PROFILE the recording compiles away and all histograms read as
+ * empty.
+ *
+ * In the host simulator (which always defines VGA_PROFILE) the cycle counts
+ * are host time scaled to the simulated CPU clock.  Use them to compare
+ * rasterizers with one another, not as a prediction of hardware timing.
+ */
+
+#ifdef VGA_PROFILE
+constexpr bool enabled = true;
+#else
+constexpr bool enabled = false;
+#endif
+
+/*
+ * The operations we can profile.
+ */
+enum class Probe {
+  // Rasterizer::rasterize, once per call.  Charged to the band that owns the
+  // Rasterizer.
+  rasterize,
+  // Copying a working buffer into the scan buffer, once per rasterized run.
+  // (Never recorded with VGA_ZERO_COPY_SCANOUT, which doesn't copy.)  Charged
+  // to the band the line came from.
+  update_scan_buffer,
+  // Setting up DMA and timers for a line, once per displayed line.  Charged to
+  // the band the line came from.
+  prepare_scanout,
+  // The application's vga_hblank_interrupt, once per line including blanking.
+  // Charged to the band of the most recently displayed line.
+  hblank_hook,
+
+  count
+};
+
+/*
+ * Number of buckets in each histogram.  Bucket 0 counts samples of zero cycles;
+ * bucket n counts samples of [2^(n-1), 2^n) cycles; the last bucket also
+ * counts anything longer.
+ */
+constexpr unsigned histogram_buckets = 20;
+
+struct Histogram {
+  unsigned samples;
+  unsigned max_cycles;
+  std::uint64_t total_cycles;
+  unsigned buckets[histogram_buckets];
+};
+
+/*
+ * Returns the histogram for the given operation in the Band at the given
+ * position in the band list (0 for the head), accumulated since the last call
+ * to reset.  Positions at or beyond max_monitored_bands read as empty.
+ *
+ * The driver updates histograms from interrupts, so for a consistent snapshot
+ * call this during vertical blank.
+ */
+Histogram get_histogram(unsigned band_index, Probe);
+
+/*
+ * Empties all histograms.
+ */
+void reset();
+
+/*
+ * Adds a sample to a histogram.  Used by the driver; applications don't need
+ * to call this.
+ */
+void record(Probe, unsigned band_index, std::uint32_t cycles);
+
+}  // namespace profile
+}  // namespace vga
+
+#endif  // VGA_PROFILE_H
@@ -0,0 +1,105 @@
+#include "vga/rast/affine.h"
+
+#include "etl/assert.h"
+#include "etl/prediction.h"
+
+#include "vga/arena.h"
+#include "vga/rast/unpack_affine.h"
+
+using std::int32_t;
+using std::uint32_t;
+
+namespace vga {
+namespace rast {
+
+Affine::Affine(unsigned disp_width, unsigned disp_height,
+               unsigned scale_x, unsigned scale_y,
+               Pixel const *texture,
+               unsigned log2_width, unsigned log2_height,
+               unsigned top_line)
+  : _width{disp_width / scale_x},
+    _height{disp_height / scale_y},
+    _scale_x{scale_x},
+    _scale_y{scale_y},
+    _top_line{top_line},
+    _texture{texture},
+    _log2_width{log2_width},
+    _log2_height{log2_height},
+    _params{arena_new_array<LineParams>(_height),
+            arena_new_array<LineParams>(_height)},
+    _page1{false},
+    _flip_pended{false} {
+  ETL_ASSERT(_width % 4 == 0);
+  ETL_ASSERT(log2_width <= 16 && log2_height <= 16);
+
+  for (unsigned i = 0; i < _height; ++i) {
+    _params[0][i] = _params[1][i] = { 0, 0, 0, 0 };
+  }
+}
+
+Affine::~Affine() {
+  _params[0] = _params[1] = nullptr;
+  _texture = nullptr;
+}
+
+__attribute__((section(".ramcode")))
+Rasterizer::RasterInfo Affine::rasterize(unsigned cycles_per_pixel,
+                                         unsigned line_number,
+                                         Pixel *target) {
+  line_number -= _top_line;
+  if (ETL_UNLIKELY(line_number == 0)) {
+    if (_flip_pended.exchange(false)) flip_now();
+  }
+
+  auto repeat = (_scale_y - 1) - (line_number % _scale_y);
+  line_number /= _scale_y;
+
+  if (ETL_UNLIKELY(line_number >= _height)) {
+    return { 0, 0, cycles_per_pixel, 0 };
+  }
+
+  // Move the integer parts of the coordinates to the top of the word.
+  auto const &p = _params[_page1][line_number];
+  unsigned u_align = 16 - _log2_width;
+  unsigned v_align = 16 - _log2_height;
+  AffineStep step = {
+    .u = uint32_t(p.u) << u_align,
+    .v = uint32_t(p.v) << v_align,
+    .du = uint32_t(p.du) << u_align,
+    .dv = uint32_t(p.dv) << v_align,
+    .u_shift = 32 - _log2_width,
+    .v_shift = 32 - _log2_height - _log2_width,
+    .x_mask = (1u << _log2_width) - 1,
+  };
+
+  unpack_affine_impl(_texture, step, target, _width);
+
+  return {
+    .offset = 0,
+    .length = _width,
+    .cycles_per_pixel = cycles_per_pixel * _scale_x,
+    .repeat_lines = repeat,
+  };
+}
+
+void Affine::set_affine(int32_t u, int32_t v,
+                        int32_t du_dx, int32_t dv_dx,
+                        int32_t du_dy, int32_t dv_dy) {
+  auto params = get_bg_params();
+  for (unsigned y = 0; y < _height; ++y) {
+    params[y] = { u, v, du_dx, dv_dx };
+    u += du_dy;
+    v += dv_dy;
+  }
+}
+
+void Affine::pend_flip() {
+  _flip_pended = true;
+}
+
+void Affine::flip_now() {
+  _page1 = !_page1;
+}
+
+}  // namespace rast
+}  // namespace vga
@@ -0,0 +1,119 @@
+#ifndef VGA_RAST_AFFINE_H
+#define VGA_RAST_AFFINE_H
+
+#include <atomic>
+#include <cstdint>
+
+#include "vga/rasterizer.h"
+
+namespace vga {
+namespace rast {
+
+/*
+ * Samples a texture along a different line on each scanline, in the manner of
+ * the SNES's "mode 7."  Choosing the lines as a rotated and scaled grid gives
+ * a rotozoomer; foreshortening them toward the top of the screen gives a
+ * perspective floor.  Either way there's no framebuffer to redraw: animating
+ * costs a table of 16 bytes per line.
+ *
+ * The texture has sides that are powers of two, and wraps around in both
+ * directions.  It's only read, so it can live in flash.
+ *
+ * Each texel costs a little over 9 cycles, so at 800x600 use scale_x of at
+ * least 2 (and expect to lean on the driver's lookahead) or 3.
+ */
+class Affine : public Rasterizer {
+public:
+  /*
+   * Where to sample a single output line: the texel coordinates of its
+   * leftmost pixel, and the step between pixels, all in 16.16 fixed point.
+   */
+  struct LineParams {
+    std::int32_t u;
+    std::int32_t v;
+    std::int32_t du;
+    std::int32_t dv;
+  };
+
+  /*
+   * Creates an Affine with the given configuration:
+   * - disp_width and disp_height give the native size of the display, e.g.
+   *   800x600.
+   * - scale_x and scale_y give the subdivision factors.  Both should be
+   *   greater than zero, and the resulting width must be a multiple of 4.
+   * - texture points to (1 << log2_width) * (1 << log2_height) pixels, by rows.
+   *   Each side may be at most 2^16 texels.
+   * - top_line applies an offset to the start of rasterization, for use when
+   *   the rasterizer starts somewhere other than the top line of the display.
+   *
+   * Two tables of get_height() LineParams are allocated from the arena, both
+   * initially zero.
+   */
+  Affine(unsigned disp_width, unsigned disp_height,
+         unsigned scale_x, unsigned scale_y,
+         Pixel const *texture,
+         unsigned log2_width, unsigned log2_height,
+         unsigned top_line = 0);
+  ~Affine();
+
+  RasterInfo rasterize(unsigned, unsigned, Pixel *) override;
+
+  unsigned get_width() const { return _width; }
+  unsigned get_height() const { return _height; }
+
+  /*
+   * Changes the texture, which must be the same size as the original.  If
+   * video is active this will take effect at the next line.
+   */
+  void set_texture(Pixel const *texture) { _texture = texture; }
+
+  /*
+   * Returns the table of LineParams not being displayed, for the application
+   * to fill in.
+   */
+  LineParams *get_bg_params() const { return _params[!_page1]; }
+
+  /*
+   * Fills the background table to display the texture through an affine
+   * transform: output pixel (x, y) shows texel
+   *   (u + x * du_dx + y * du_dy, v + x * dv_dx + y * dv_dy)
+   * in 16.16 fixed point.
+   */
+  void set_affine(std::int32_t u, std::int32_t v,
+                  std::int32_t du_dx, std::int32_t dv_dx,
+                  std::int32_t du_dy, std::int32_t dv_dy);
+
+  /*
+   * Records that the tables should be swapped, which will happen next time
+   * rasterize is asked to draw the top_line -- that is, at the start of the
+   * next frame.
+   *
+   * Calling flip_now between pend_flip and when the flip occurs is a recipe
+   * for madness.
+   */
+  void pend_flip();
+
+  /*
+   * Swaps the tables right now.  If video is active this will take effect at
+   * the next line.
+   */
+  void flip_now();
+
+private:
+  unsigned _width;
+  unsigned _height;
+  unsigned _scale_x;
+  unsigned _scale_y;
+  unsigned _top_line;
+  Pixel const *_texture;
+  unsigned _log2_width;
+  unsigned _log2_height;
+  LineParams *_params[2];
+  bool _page1;
+  std::atomic<bool> _flip_pended;
+};
+
+}  // namespace rast
+}  // namespace vga
+
+#endif  // VGA_RAST_AFFINE_H
@@ -88,13 +88,13 @@ void Bitmap_1::flip_now() {
 }
 
 bool Bitmap_1::can_fg_use_bitband() const {
-  unsigned addr = reinterpret_cast<unsigned>(_fb[_page1]);
+  auto addr = reinterpret_cast<std::uintptr_t>(_fb[_page1]);
   return (addr >= 0x20000000 && addr < 0x20100000)
       || (addr < 0x100000);
 }
 
 bool Bitmap_1::can_bg_use_bitband() const {
-  unsigned addr = reinterpret_cast<unsigned>(_fb[!_page1]);
+  auto addr = reinterpret_cast<std::uintptr_t>(_fb[!_page1]);
   return (addr >= 0x20000000 && addr < 0x20100000)
       || (addr < 0x100000);
 }
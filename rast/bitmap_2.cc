@@ -0,0 +1,108 @@
+#include "vga/rast/bitmap_2.h"
+
+#include <cstdint>
+
+#include "etl/assert.h"
+#include "etl/prediction.h"
+
+#include "vga/arena.h"
+#include "vga/copy_words.h"
+#include "vga/vga.h"
+#include "vga/rast/unpack_2bpp.h"
+
+using std::uint32_t;
+
+namespace vga {
+namespace rast {
+
+Bitmap_2::Bitmap_2(unsigned width, unsigned height, unsigned top_line)
+  : Bitmap_2(width, height, nullptr, top_line) {}
+
+Bitmap_2::Bitmap_2(unsigned width,
+                   unsigned height,
+                   Pixel const * background,
+                   unsigned top_line)
+  : _lines(height),
+    _words_per_line(width / 16),
+    _top_line(top_line),
+    _page1(false),
+    _flip_pended(false),
+    _clut{ 0, 0x15, 0x2A, 0x3F },
+    // The overlay unpacker needs a second table of masks.
+    _lut{ arena_new_array<uint32_t>(background ? 512 : 256) },
+    _fb{ arena_new_array<uint32_t>(_words_per_line * _lines),
+         arena_new_array<uint32_t>(_words_per_line * _lines) },
+    _background{background} {
+  ETL_ASSERT(width % 16 == 0);
+  update_lut();
+}
+
+Bitmap_2::~Bitmap_2() {
+  _fb[0] = _fb[1] = nullptr;
+  _lut = nullptr;
+  _background = nullptr;
+}
+
+void Bitmap_2::update_lut() {
+  for (unsigned byte = 0; byte < 256; ++byte) {
+    uint32_t colors = 0, mask = 0;
+    for (unsigned i = 0; i < 4; ++i) {
+      unsigned index = (byte >> (i * 2)) & 3;
+      colors |= uint32_t(_clut[index]) << (i * 8);
+      if (index == 0) mask |= uint32_t(0xFF) << (i * 8);
+    }
+    _lut[byte] = colors;
+    if (_background) _lut[256 + byte] = mask;
+  }
+}
+
+__attribute__((section(".ramcode")))
+Rasterizer::RasterInfo Bitmap_2::rasterize(unsigned cycles_per_pixel,
+                                           unsigned line_number,
+                                           Pixel *target) {
+  line_number -= _top_line;
+  if (ETL_UNLIKELY(line_number == 0)) {
+    if (_flip_pended.exchange(false)) flip_now();
+  } else if (ETL_UNLIKELY(line_number >= _lines)) {
+    return { 0, 0, cycles_per_pixel, 0 };
+  }
+
+  uint32_t const *src = _fb[_page1] + _words_per_line * line_number;
+
+  if (_background) {
+    auto bg = _background + (_words_per_line * 16) * line_number;
+    unpack_2bpp_overlay_impl(src, _lut, target, _words_per_line, bg);
+  } else {
+    unpack_2bpp_impl(src, _lut, target, _words_per_line);
+  }
+
+  return {
+    .offset = 0,
+    .length = _words_per_line * 16,
+    .cycles_per_pixel = cycles_per_pixel,
+    .repeat_lines = 0,
+  };
+}
+
+void Bitmap_2::pend_flip() {
+  _flip_pended = true;
+}
+
+void Bitmap_2::flip_now() {
+  _page1 = !_page1;
+}
+
+void Bitmap_2::copy_bg_to_fg() const {
+  copy_words(_fb[!_page1],
+             _fb[_page1],
+             _words_per_line * _lines);
+}
+
+void Bitmap_2::set_color(unsigned index, Pixel c) {
+  ETL_ASSERT(index < 4);
+  _clut[index] = c;
+  update_lut();
+}
+
+}  // namespace rast
+}  // namespace vga
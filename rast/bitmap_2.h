@@ -0,0 +1,85 @@
+#ifndef VGA_RAST_BITMAP_2_H
+#define VGA_RAST_BITMAP_2_H
+
+#include <atomic>
+#include <cstdint>
+
+#include "vga/rasterizer.h"
+
+namespace vga {
+namespace rast {
+
+/*
+ * A four-color bitmap rasterizer, for when Bitmap_1's two colors aren't enough
+ * and Palette8's 256 aren't needed.  Pixels are packed 16 to a word, the
+ * leftmost in bits 1:0.  An 800x300 page takes 60KB.
+ *
+ * Like Bitmap_1, this is double-buffered, and can optionally treat color zero
+ * as transparent, showing a background image through it.
+ */
+class Bitmap_2 : public Rasterizer {
+public:
+  /*
+   * Creates a 2bpp bitmap rasterizer with the given width, height, and
+   * optional offset.  The width must be a multiple of 16.
+   */
+  Bitmap_2(unsigned width, unsigned height, unsigned top_line = 0);
+
+  /*
+   * Creates a 2bpp bitmap rasterizer with the given width, height, background
+   * image, and optional offset.  The width must be a multiple of 16, and the
+   * background must be word-aligned.
+   */
+  Bitmap_2(unsigned width, unsigned height, Pixel const * background,
+           unsigned top_line = 0);
+
+  ~Bitmap_2();
+
+  RasterInfo rasterize(unsigned, unsigned, Pixel *) override;
+
+  /*
+   * Flips the display pages at the next vblank.
+   */
+  void pend_flip();
+
+  /*
+   * Flips the display pages right fricking now.
+   */
+  void flip_now();
+
+  /*
+   * Sets one of the four colors.  Color zero is ignored if there's a
+   * background.  This rebuilds a 256-entry lookup table, so it's not free; if
+   * video is active, the line being rasterized may show a mix of old and new
+   * colors.
+   */
+  void set_color(unsigned index, Pixel);
+  Pixel get_color(unsigned index) const { return _clut[index]; }
+
+  unsigned get_width() const { return _words_per_line * 16; }
+  unsigned get_height() const { return _lines; }
+  unsigned get_words_per_line() const { return _words_per_line; }
+
+  std::uint32_t *get_fg_buffer() const { return _fb[_page1]; }
+  std::uint32_t *get_bg_buffer() const { return _fb[!_page1]; }
+
+  void copy_bg_to_fg() const;
+
+private:
+  unsigned _lines;
+  unsigned _words_per_line;
+  unsigned _top_line;
+  bool _page1;
+  std::atomic<bool> _flip_pended;
+  Pixel _clut[4];
+  std::uint32_t *_lut;
+  std::uint32_t *_fb[2];
+  Pixel const * _background;
+
+  void update_lut();
+};
+
+}  // namespace rast
+}  // namespace vga
+
+#endif  // VGA_RAST_BITMAP_2_H
@@ -20,7 +20,8 @@ Direct::Direct(unsigned disp_width, unsigned disp_height,
     _fb{arena_new_array<Pixel>(_width * _height),
         arena_new_array<Pixel>(_width * _height)},
     _page1{false},
-    _flip_pended{false} {
+    _flip_pended{false},
+    _dirty{_height} {
   for (unsigned i = 0; i < _width * _height; ++i) {
     _fb[0][i] = 0;
     _fb[1][i] = 0;
@@ -36,6 +37,10 @@ auto Direct::rasterize(unsigned cycles_per_pixel,
                        unsigned line_number,
                        Pixel *target) -> RasterInfo {
   line_number -= _top_line;
+  if (ETL_UNLIKELY(line_number == 0)) {
+    if (_flip_pended.exchange(false)) flip_now();
+  }
+
   auto repeat = (_scale_y - 1) - (line_number % _scale_y);
   line_number /= _scale_y;
 
@@ -66,5 +71,12 @@ void Direct::pend_flip() {
   _flip_pended = true;
 }
 
+void Direct::sync_back_from_front() {
+  _dirty.copy_dirty(
+      (uint32_t const *) (void const *) _fb[_page1],
+      (uint32_t *) (void *) _fb[!_page1],
+      _width / sizeof(uint32_t));
+}
+
 }  // namespace rast
 }  // namespace vga
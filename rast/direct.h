@@ -4,6 +4,7 @@
 #include <atomic>
 
 #include "vga/rasterizer.h"
+#include "vga/rast/dirty_rows.h"
 
 namespace vga {
 namespace rast {
@@ -44,6 +45,11 @@ public:
    */
   void pend_flip();
 
+  /*
+   * Checks whether a flip requested by pend_flip is still outstanding.
+   */
+  bool is_flip_pended() const { return _flip_pended; }
+
   /*
    * Flips pages right now.  If video is active this will take effect at the
    * next line.
@@ -58,6 +64,22 @@ public:
   Pixel *get_fg_buffer() const { return _fb[_page1]; }
   Pixel *get_bg_buffer() const { return _fb[!_page1]; }
 
+  /*
+   * Records that rows of the background buffer have been changed, so that
+   * sync_back_from_front knows to copy them after the next flip.
+   */
+  void mark_dirty(unsigned first_row, unsigned count = 1) {
+    _dirty.mark(first_row, count);
+  }
+
+  /*
+   * Brings the background buffer up to date with the foreground after a flip,
+   * by copying only the rows marked dirty since the last sync.  Call this
+   * after the flip has happened and before drawing into the new background
+   * buffer; with pend_flip, wait until is_flip_pended returns false.
+   */
+  void sync_back_from_front();
+
 private:
   unsigned _width;
   unsigned _height;
@@ -67,6 +89,7 @@ private:
   Pixel *_fb[2];
   bool _page1;
   std::atomic<bool> _flip_pended;
+  DirtyRows _dirty;
 };
 
 }  // namespace rast
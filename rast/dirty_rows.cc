@@ -0,0 +1,69 @@
+#include "vga/rast/dirty_rows.h"
+
+#include "vga/arena.h"
+#include "vga/copy_words.h"
+
+using std::uint32_t;
+
+namespace vga {
+namespace rast {
+
+DirtyRows::DirtyRows(unsigned rows)
+  : _rows(rows),
+    _bits(arena_new_array<uint32_t>((rows + 31) / 32)) {
+  clear();
+}
+
+DirtyRows::~DirtyRows() {
+  _bits = nullptr;
+}
+
+void DirtyRows::mark(unsigned first, unsigned count) {
+  if (first >= _rows) return;
+  if (count > _rows - first) count = _rows - first;
+
+  for (unsigned row = first; row < first + count; ++row) {
+    _bits[row / 32] |= uint32_t(1) << (row % 32);
+  }
+}
+
+void DirtyRows::mark_all() {
+  mark(0, _rows);
+}
+
+void DirtyRows::clear() {
+  for (unsigned i = 0; i < (_rows + 31) / 32; ++i) {
+    _bits[i] = 0;
+  }
+}
+
+void DirtyRows::copy_dirty(uint32_t const *source,
+                           uint32_t *dest,
+                           unsigned words_per_row) {
+  unsigned row = 0;
+  while (row < _rows) {
+    // Skip clean rows a word of the bitmap at a time where we can.
+    if (row % 32 == 0 && _bits[row / 32] == 0) {
+      row += 32;
+      continue;
+    }
+    if (!is_dirty(row)) {
+      ++row;
+      continue;
+    }
+
+    // Copy the whole run at once; copy_words prefers big transfers.
+    unsigned end = row + 1;
+    while (end < _rows && is_dirty(end)) ++end;
+
+    copy_words(source + row * words_per_row,
+               dest + row * words_per_row,
+               (end - row) * words_per_row);
+    row = end;
+  }
+
+  clear();
+}
+
+}  // namespace rast
+}  // namespace vga
@@ -0,0 +1,53 @@
+#ifndef VGA_RAST_DIRTY_ROWS_H
+#define VGA_RAST_DIRTY_ROWS_H
+
+#include <cstdint>
+
+namespace vga {
+namespace rast {
+
+/*
+ * A bitmap recording which rows of a double-buffered framebuffer have changed,
+ * so that bringing the other page up to date costs in proportion to the
+ * change rather than to the screen.
+ */
+class DirtyRows {
+public:
+  /*
+   * Creates a DirtyRows covering 'rows' rows, all initially clean.  The bitmap
+   * is allocated from the arena.
+   */
+  explicit DirtyRows(unsigned rows);
+  ~DirtyRows();
+
+  /*
+   * Marks 'count' rows starting at 'first' as changed.  Rows beyond the end
+   * are ignored.
+   */
+  void mark(unsigned first, unsigned count = 1);
+
+  void mark_all();
+  void clear();
+
+  bool is_dirty(unsigned row) const {
+    return (_bits[row / 32] >> (row % 32)) & 1;
+  }
+
+  /*
+   * Copies each run of dirty rows from 'source' to 'dest' -- both consisting
+   * of rows of 'words_per_row' words -- using copy_words, and marks them all
+   * clean.
+   */
+  void copy_dirty(std::uint32_t const *source,
+                  std::uint32_t *dest,
+                  unsigned words_per_row);
+
+private:
+  unsigned _rows;
+  std::uint32_t *_bits;
+};
+
+}  // namespace rast
+}  // namespace vga
+
+#endif  // VGA_RAST_DIRTY_ROWS_H
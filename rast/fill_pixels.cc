@@ -0,0 +1,36 @@
+#include "vga/rast/fill_pixels.h"
+
+using std::uint8_t;
+using std::uint32_t;
+using std::uintptr_t;
+
+namespace vga {
+namespace rast {
+
+/*
+ * Portable equivalent of fill_pixels.S.
+ */
+__attribute__((section(".ramcode")))
+void fill_pixels_impl(uint8_t *render_target,
+                      unsigned count,
+                      uint8_t color) {
+  if (count >= 8) {
+    while (reinterpret_cast<uintptr_t>(render_target) & 3) {
+      *render_target++ = color;
+      --count;
+    }
+
+    uint32_t colors = color * 0x01010101u;
+    auto words = reinterpret_cast<uint32_t *>(render_target);
+    for (unsigned i = 0; i < count / 4; ++i) {
+      words[i] = colors;
+    }
+    render_target += count & ~3u;
+    count &= 3;
+  }
+
+  while (count--) *render_target++ = color;
+}
+
+}  // namespace rast
+}  // namespace vga
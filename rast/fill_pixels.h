@@ -0,0 +1,21 @@
+#ifndef VGA_RAST_FILL_PIXELS_H
+#define VGA_RAST_FILL_PIXELS_H
+
+#include <cstdint>
+
+namespace vga {
+namespace rast {
+
+/*
+ * Sets 'count' pixels starting at 'render_target', which need not be aligned,
+ * to 'color'.  Runs of more than a few pixels are filled with word stores.
+ * 'count' may be zero.
+ */
+void fill_pixels_impl(std::uint8_t *render_target,
+                      unsigned count,
+                      std::uint8_t color);
+
+}  // namespace rast
+}  // namespace vga
+
+#endif  // VGA_RAST_FILL_PIXELS_H
@@ -0,0 +1,119 @@
+#include "vga/rast/glyph_cache.h"
+
+#include <cstring>
+
+#include "etl/assert.h"
+#include "etl/prediction.h"
+
+#include "vga/arena.h"
+
+using std::uint8_t;
+using std::uint32_t;
+
+namespace vga {
+namespace rast {
+
+// Marks a slot that has never been claimed; no real color pair has bits set
+// above 15.
+static constexpr uint32_t unused = ~0u;
+
+GlyphCache::GlyphCache(unsigned color_pairs, unsigned cell_width)
+  : _slot_count(color_pairs),
+    _cell_width(cell_width),
+    _next_victim(0),
+    _slots(arena_new_array<Slot>(color_pairs)),
+    _stats{} {
+  ETL_ASSERT(color_pairs > 0);
+  ETL_ASSERT(cell_width <= 10);
+  for (unsigned i = 0; i < color_pairs; ++i) {
+    _slots[i].colors = unused;
+    _slots[i].rows = arena_new_array<uint32_t>(256 * words_per_row);
+  }
+}
+
+GlyphCache::~GlyphCache() {
+  _slots = nullptr;
+}
+
+__attribute__((section(".ramcode")))
+GlyphCache::Slot *GlyphCache::claim(uint32_t colors) {
+  for (unsigned i = 0; i < _slot_count; ++i) {
+    if (_slots[i].colors == colors) return &_slots[i];
+  }
+
+  auto &slot = _slots[_next_victim];
+  _next_victim = (_next_victim + 1) % _slot_count;
+
+  if (slot.colors != unused) ++_stats.evictions;
+  slot.colors = colors;
+  for (auto &v : slot.valid) v = 0;
+  return &slot;
+}
+
+__attribute__((section(".ramcode")))
+void GlyphCache::unpack(uint32_t const *cells,
+                        uint8_t const *font,
+                        Rasterizer::Pixel *target,
+                        unsigned count,
+                        unsigned attribute_mask) {
+  Slot *slot = nullptr;
+  uint32_t last_colors = unused;
+
+  for (unsigned c = 0; c < count; ++c) {
+    uint32_t cell = cells[c];
+    uint8_t fore = uint8_t(cell >> 16);
+    uint8_t back = uint8_t(cell >> 8);
+    unsigned bits = font[uint8_t(cell)];
+
+    // Apply attributes as the unpack_text kernels do.
+    uint32_t effects = cell & attribute_mask;
+    if (ETL_UNLIKELY(effects)) {
+      if (effects & (1 << 24)) {
+        auto t = fore;
+        fore = back;
+        back = t;
+      }
+      if (effects & (1 << 26)) {
+        bits = 0;
+      } else if (effects & (1 << 25)) {
+        bits = 0xFF;
+        back = fore;
+      }
+    }
+
+    // Runs of characters in the same colors are the common case.
+    uint32_t colors = uint32_t(fore) << 8 | back;
+    if (ETL_UNLIKELY(colors != last_colors)) {
+      slot = claim(colors);
+      last_colors = colors;
+    }
+
+    auto row = slot->rows + bits * words_per_row;
+    auto &valid = slot->valid[bits / 32];
+    uint32_t valid_bit = uint32_t(1) << (bits % 32);
+    if (ETL_LIKELY(valid & valid_bit)) {
+      ++_stats.hits;
+    } else {
+      ++_stats.misses;
+      auto pixels = reinterpret_cast<uint8_t *>(row);
+      for (unsigned i = 0; i < 8; ++i) {
+        pixels[i] = ((bits >> i) & 1) ? fore : back;
+      }
+      for (unsigned i = 8; i < 12; ++i) pixels[i] = back;
+      valid |= valid_bit;
+    }
+
+    // Target may be unaligned; let the compiler pick unaligned
+    // stores.  Pixels past the cell are overwritten by the next, except after
+    // the last, where they'd be outside the line.
+    if (ETL_LIKELY(c + 1 < count)) {
+      std::memcpy(target, row, words_per_row * sizeof(uint32_t));
+    } else {
+      std::memcpy(target, row, _cell_width);
+    }
+    target += _cell_width;
+  }
+}
+
+}  // namespace rast
+}  // namespace vga
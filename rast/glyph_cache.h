@@ -0,0 +1,78 @@
+#ifndef VGA_RAST_GLYPH_CACHE_H
+#define VGA_RAST_GLYPH_CACHE_H
+
+#include <cstdint>
+
+#include "vga/rasterizer.h"
+
+namespace vga {
+namespace rast {
+
+/*
+ * A cache of glyph rows already expanded into pixels, for text whose colors
+ * come from a small set of foreground/background pairs.  With the cache, a
+ * character costs a lookup and three word copies instead of an expansion.
+ *
+ * Entries are keyed by the glyph row's bit pattern rather than by character,
+ * so each color pair needs at most 256 of them (3KiB), filled in as they're
+ * first used.  When a new color pair appears and all slots are taken, the
+ * slot claimed longest ago is emptied for it.
+ *
+ * Whether this beats the unpack_text kernels depends on the
+ * screen; the statistics are there to tell.  A screen with more color pairs
+ * than slots will thrash.
+ */
+class GlyphCache {
+public:
+  struct Stats {
+    unsigned hits;        // Characters drawn from the cache.
+    unsigned misses;      // Characters expanded into the cache.
+    unsigned evictions;   // Slots emptied for a new color pair.
+  };
+
+  /*
+   * Creates a cache with room for 'color_pairs' (at least one) pairs,
+   * allocated from the arena, for character cells 'cell_width' (at most 10)
+   * pixels wide.  Cells show as much of the glyph as fits, and gutter beyond
+   * that, as the unpack_text kernels do.
+   */
+  explicit GlyphCache(unsigned color_pairs, unsigned cell_width = 10);
+  ~GlyphCache();
+
+  /*
+   * Equivalent to the unpack_text kernel for the cell width, but using the
+   * cache.
+   */
+  void unpack(std::uint32_t const *cells,
+              std::uint8_t const *font,
+              Rasterizer::Pixel *target,
+              unsigned count,
+              unsigned attribute_mask);
+
+  Stats get_stats() const { return _stats; }
+  void reset_stats() { _stats = {}; }
+
+private:
+  // Each expanded row is three words: the cell's pixels, padded with
+  // background that the next character overwrites.
+  static constexpr unsigned words_per_row = 3;
+
+  struct Slot {
+    std::uint32_t colors;   // Foreground << 8 | background.
+    std::uint32_t valid[256 / 32];
+    std::uint32_t *rows;
+  };
+
+  unsigned _slot_count;
+  unsigned _cell_width;
+  unsigned _next_victim;
+  Slot *_slots;
+  Stats _stats;
+
+  Slot *claim(std::uint32_t colors);
+};
+
+}  // namespace rast
+}  // namespace vga
+
+#endif  // VGA_RAST_GLYPH_CACHE_H
@@ -0,0 +1,102 @@
+#include "vga/rast/horizontal_split.h"
+
+#include "etl/assert.h"
+
+#include "vga/rast/fill_pixels.h"
+#include "vga/rast/stretch.h"
+
+namespace vga {
+namespace rast {
+
+// How far past the right of its region a Rasterizer may write.
+static constexpr unsigned guard_pixels = Rasterizer::max_overrun;
+
+constexpr unsigned HorizontalSplit::max_regions;
+
+HorizontalSplit::HorizontalSplit(Region const *first) {
+  set_regions(first);
+}
+
+void HorizontalSplit::set_regions(Region const *first) {
+  unsigned x = 0;
+  unsigned count = 0;
+  for (auto r = first; r; r = r->next) {
+    ETL_ASSERT(count < max_regions);
+    ETL_ASSERT(r->width % 4 == 0);
+    _slots[count++] = { r->rasterizer, x, r->width };
+    x += r->width;
+  }
+  _count = count;
+  _width = x;
+}
+
+__attribute__((section(".ramcode")))
+void HorizontalSplit::fit(Pixel *out, unsigned width,
+                          RasterInfo const &info, unsigned cycles_per_pixel) {
+  int offset = info.offset;
+  unsigned length = info.length;
+
+  unsigned factor = info.cycles_per_pixel / cycles_per_pixel;
+  if (factor > 1) {
+    int room = int(width) - (offset > 0 ? offset : 0);
+    length = room > 0 ? stretch_pixels(out, length, factor, unsigned(room))
+                      : 0;
+  }
+
+  // Offsets are rare, so shift pixels the simple way.
+  unsigned start = 0;
+  if (offset > 0) {
+    start = unsigned(offset) < width ? unsigned(offset) : width;
+    if (length > width - start) length = width - start;
+    for (unsigned i = length; i-- > 0; ) out[start + i] = out[i];
+    fill_pixels_impl(out, start, 0);
+  } else if (offset < 0) {
+    unsigned skip = unsigned(-offset);
+    length = length > skip ? length - skip : 0;
+    for (unsigned i = 0; i < length; ++i) out[i] = out[i + skip];
+  }
+
+  if (length > width - start) length = width - start;
+  fill_pixels_impl(out + start + length, width - start - length, 0);
+}
+
+__attribute__((section(".ramcode")))
+Rasterizer::RasterInfo HorizontalSplit::rasterize(unsigned cycles_per_pixel,
+                                                  unsigned line_number,
+                                                  Pixel *target) {
+  unsigned repeat = ~0u;
+
+  for (unsigned i = _count; i-- > 0; ) {
+    auto const &slot = _slots[i];
+    auto out = target + slot.x;
+
+    // Protect the region to the right, which is already drawn.
+    bool guard = i + 1 < _count;
+    Pixel saved[guard_pixels];
+    if (guard) {
+      for (unsigned j = 0; j < guard_pixels; ++j) {
+        saved[j] = out[slot.width + j];
+      }
+    }
+
+    auto info = slot.rasterizer->rasterize(cycles_per_pixel, line_number, out);
+    if (info.repeat_lines < repeat) repeat = info.repeat_lines;
+    fit(out, slot.width, info, cycles_per_pixel);
+
+    if (guard) {
+      for (unsigned j = 0; j < guard_pixels; ++j) {
+        out[slot.width + j] = saved[j];
+      }
+    }
+  }
+
+  return {
+    .offset = 0,
+    .length = _width,
+    .cycles_per_pixel = cycles_per_pixel,
+    .repeat_lines = _count ? repeat : 0,
+  };
+}
+
+}  // namespace rast
+}  // namespace vga
@@ -0,0 +1,78 @@
+#ifndef VGA_RAST_HORIZONTAL_SPLIT_H
+#define VGA_RAST_HORIZONTAL_SPLIT_H
+
+#include "vga/rasterizer.h"
+
+namespace vga {
+namespace rast {
+
+/*
+ * Divides lines horizontally among several Rasterizers, the way a Band list
+ * divides the screen vertically -- e.g. a Text_10x16 status column beside a
+ * Palette8 view.  None of the Rasterizers need know.
+ *
+ * Each Rasterizer draws directly into its own range of the line, as though
+ * it were the whole line, and should be configured to produce no more than its
+ * region's width.  Its result is adjusted to fit: offsets are applied
+ * within the region, wide pixels (a multiple of the cycles_per_pixel it was
+ * given, as from a scaled Palette8) are stretched, and anything left over is
+ * black.  Output past the end of the region is clipped.  The line as a whole
+ * repeats only as often as every region allows.
+ *
+ * Regions are drawn right to left, so that a Rasterizer that writes a little
+ * to the left of its buffer (as some do, into the driver's padding) doesn't
+ * damage its neighbor; writes past the right of a region are undone.
+ */
+class HorizontalSplit : public Rasterizer {
+public:
+  /*
+   * A region's width must be a multiple of 4, so that every region starts on
+   * a word boundary: several Rasterizers (e.g. Direct, Bitmap_2) store whole
+   * words.  For a Text, that can mean leaving a column off -- 13 columns of
+   * Text_10x16 are 130 pixels, so use 12 (120) or pad the region to 132.
+   */
+  struct Region {
+    Rasterizer *rasterizer;
+    unsigned width;         // Pixels at the display's native scale.
+    Region const *next;     // Region to the right, or null.
+  };
+
+  static constexpr unsigned max_regions = 8;
+
+  /*
+   * Creates a HorizontalSplit from the list of (at most max_regions) regions
+   * starting at 'first', leftmost first.
+   */
+  explicit HorizontalSplit(Region const *first);
+
+  RasterInfo rasterize(unsigned, unsigned, Pixel *) override;
+
+  /*
+   * Replaces the list of regions.  Only safe if this rasterizer isn't in use
+   * by the driver, or from a VblankJob.
+   */
+  void set_regions(Region const *first);
+
+  unsigned get_width() const { return _width; }
+
+private:
+  // The region list, flattened so that rasterizing needn't chase pointers or
+  // add up widths.
+  struct Slot {
+    Rasterizer *rasterizer;
+    unsigned x;
+    unsigned width;
+  };
+
+  unsigned _width;
+  unsigned _count;
+  Slot _slots[max_regions];
+
+  static void fit(Pixel *out, unsigned width,
+                  RasterInfo const &info, unsigned cycles_per_pixel);
+};
+
+}  // namespace rast
+}  // namespace vga
+
+#endif  // VGA_RAST_HORIZONTAL_SPLIT_H
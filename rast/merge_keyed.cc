@@ -0,0 +1,22 @@
+#include "vga/rast/merge_keyed.h"
+
+using std::uint8_t;
+
+namespace vga {
+namespace rast {
+
+/*
+ * Portable equivalent of merge_keyed.S.
+ */
+__attribute__((section(".ramcode")))
+void merge_keyed_impl(uint8_t *render_target,
+                      uint8_t const *source,
+                      unsigned count,
+                      uint8_t key) {
+  for (unsigned i = 0; i < count; ++i) {
+    if (render_target[i] == key) render_target[i] = source[i];
+  }
+}
+
+}  // namespace rast
+}  // namespace vga
@@ -0,0 +1,22 @@
+#ifndef VGA_RAST_MERGE_KEYED_H
+#define VGA_RAST_MERGE_KEYED_H
+
+#include <cstdint>
+
+namespace vga {
+namespace rast {
+
+/*
+ * Replaces each of 'count' pixels at 'render_target' that is equal to 'key'
+ * with the corresponding pixel from 'source'.  Neither need be aligned.
+ * 'count' may be zero.
+ */
+void merge_keyed_impl(std::uint8_t *render_target,
+                      std::uint8_t const *source,
+                      unsigned count,
+                      std::uint8_t key);
+
+}  // namespace rast
+}  // namespace vga
+
+#endif  // VGA_RAST_MERGE_KEYED_H
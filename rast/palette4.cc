@@ -0,0 +1,76 @@
+#include "vga/rast/palette4.h"
+
+#include "etl/assert.h"
+#include "etl/prediction.h"
+
+#include "vga/arena.h"
+#include "vga/vga.h"
+#include "vga/rast/unpack_p16.h"
+
+using std::uint8_t;
+
+namespace vga {
+namespace rast {
+
+Palette4::Palette4(unsigned disp_width, unsigned disp_height,
+                   unsigned scale_x, unsigned scale_y,
+                   unsigned top_line)
+  : _width{disp_width / scale_x},
+    _height{disp_height / scale_y},
+    _scale_x{scale_x},
+    _scale_y{scale_y},
+    _top_line{top_line},
+    _fb{arena_new_array<uint8_t>(_width / 2 * _height),
+        arena_new_array<uint8_t>(_width / 2 * _height)},
+    _palette{},
+    _page1{false},
+    _flip_pended{false} {
+  ETL_ASSERT(_width % 8 == 0);
+
+  for (unsigned i = 0; i < _width / 2 * _height; ++i) {
+    _fb[0][i] = 0;
+    _fb[1][i] = 0;
+  }
+}
+
+Palette4::~Palette4() {
+  _fb[0] = _fb[1] = nullptr;
+}
+
+__attribute__((section(".ramcode")))
+Rasterizer::RasterInfo Palette4::rasterize(unsigned cycles_per_pixel,
+                                           unsigned line_number,
+                                           Pixel *target) {
+  line_number -= _top_line;
+  if (ETL_UNLIKELY(line_number == 0)) {
+    if (_flip_pended.exchange(false)) flip_now();
+  }
+
+  auto repeat = (_scale_y - 1) - (line_number % _scale_y);
+  line_number /= _scale_y;
+
+  if (ETL_UNLIKELY(line_number >= _height)) {
+    return { 0, 0, cycles_per_pixel, 0 };
+  }
+
+  uint8_t const *src = _fb[_page1] + _width / 2 * line_number;
+
+  unpack_p16_impl(src, target, _width / 8, _palette);
+  return {
+    .offset = 0,
+    .length = _width,
+    .cycles_per_pixel = cycles_per_pixel * _scale_x,
+    .repeat_lines = repeat,
+  };
+}
+
+void Palette4::pend_flip() {
+  _flip_pended = true;
+}
+
+void Palette4::flip_now() {
+  _page1 = !_page1;
+}
+
+}  // namespace rast
+}  // namespace vga
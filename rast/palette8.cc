@@ -21,7 +21,8 @@ Palette8::Palette8(unsigned disp_width, unsigned disp_height,
     _fb{arena_new_array<Index>(_width * _height),
         arena_new_array<Index>(_width * _height)},
     _palette{arena_new_array<Pixel>(256)},
-    _page1{false} {
+    _page1{false},
+    _dirty{_height} {
 
   for (unsigned i = 0; i < _width * _height; ++i) {
     _fb[0][i] = 0;
@@ -64,5 +65,12 @@ void Palette8::flip_now() {
   _page1 = !_page1;
 }
 
+void Palette8::sync_back_from_front() {
+  _dirty.copy_dirty(
+      (uint32_t const *) (void const *) _fb[_page1],
+      (uint32_t *) (void *) _fb[!_page1],
+      _width / sizeof(uint32_t));
+}
+
 }  // namespace rast
 }  // namespace vga
@@ -5,6 +5,7 @@
 #include <cstdint>
 
 #include "vga/rasterizer.h"
+#include "vga/rast/dirty_rows.h"
 
 namespace vga {
 namespace rast {
@@ -52,6 +53,21 @@ public:
   Index *get_fg_buffer() const { return _fb[_page1]; }
   Index *get_bg_buffer() const { return _fb[!_page1]; }
 
+  /*
+   * Records that rows of the background buffer have been changed, so that
+   * sync_back_from_front knows to copy them after the next flip.
+   */
+  void mark_dirty(unsigned first_row, unsigned count = 1) {
+    _dirty.mark(first_row, count);
+  }
+
+  /*
+   * Brings the background buffer up to date with the foreground after a flip,
+   * by copying only the rows marked dirty since the last sync.  Call this
+   * after flip_now and before drawing into the new background buffer.
+   */
+  void sync_back_from_front();
+
   Pixel * get_palette() { return _palette; }
   Pixel const * get_palette() const { return _palette; }
 
@@ -64,6 +80,7 @@ private:
   Index *_fb[2];
   Pixel * _palette;
   bool _page1;
+  DirtyRows _dirty;
 };
 
 }  // namespace rast
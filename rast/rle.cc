@@ -0,0 +1,81 @@
+#include "vga/rast/rle.h"
+
+#include "etl/prediction.h"
+
+#include "vga/rast/fill_pixels.h"
+
+using std::uint8_t;
+
+namespace vga {
+namespace rast {
+
+// Limits the search for identical lines below the current one, so that e.g. a
+// blank image doesn't make one line compare every offset.  A longer run is
+// picked up again by the line after this many.
+static constexpr unsigned max_repeat = 32;
+
+template <bool palettized>
+__attribute__((section(".ramcode")))
+static void decode_line(uint8_t const *src,
+                        Rasterizer::Pixel *out,
+                        unsigned width,
+                        Rasterizer::Pixel const *palette) {
+  auto end = out + width;
+  while (out < end) {
+    unsigned control = *src++;
+    unsigned count = (control & 0x7F) + 1;
+    if (control & 0x80) {
+      auto color = *src++;
+      fill_pixels_impl(out, count, palettized ? palette[color] : color);
+      out += count;
+    } else {
+      for (unsigned i = 0; i < count; ++i) {
+        out[i] = palettized ? palette[src[i]] : src[i];
+      }
+      src += count;
+      out += count;
+    }
+  }
+}
+
+Rle::Rle(RleImage const &image, unsigned top_line)
+  : _image(image),
+    _top_line(top_line),
+    _palette(nullptr) {}
+
+__attribute__((section(".ramcode")))
+Rasterizer::RasterInfo Rle::rasterize(unsigned cycles_per_pixel,
+                                      unsigned line_number,
+                                      Pixel *target) {
+  line_number -= _top_line;
+  if (ETL_UNLIKELY(line_number >= _image.height)) {
+    return { 0, 0, cycles_per_pixel, 0 };
+  }
+
+  auto offsets = _image.line_offsets;
+  auto src = _image.data + offsets[line_number];
+
+  if (_palette) {
+    decode_line<true>(src, target, _image.width, _palette);
+  } else {
+    decode_line<false>(src, target, _image.width, nullptr);
+  }
+
+  // The encoder shares data between identical lines; repeat them.
+  unsigned repeat = 0;
+  while (repeat < max_repeat
+         && line_number + repeat + 1 < _image.height
+         && offsets[line_number + repeat + 1] == offsets[line_number]) {
+    ++repeat;
+  }
+
+  return {
+    .offset = 0,
+    .length = _image.width,
+    .cycles_per_pixel = cycles_per_pixel,
+    .repeat_lines = repeat,
+  };
+}
+
+}  // namespace rast
+}  // namespace vga
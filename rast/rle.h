@@ -0,0 +1,67 @@
+#ifndef VGA_RAST_RLE_H
+#define VGA_RAST_RLE_H
+
+#include <cstdint>
+
+#include "vga/rasterizer.h"
+
+namespace vga {
+namespace rast {
+
+/*
+ * A run-length encoded image, typically generated by tool/rle_encode.rb and
+ * compiled into flash.
+ *
+ * Each line is encoded separately, as a series of packets.  A packet starts
+ * with a control byte c:
+ * - If bit 7 of c is clear, it's followed by (c + 1) literal pixels.
+ * - If bit 7 of c is set, it's followed by one pixel, repeated
+ *   ((c & 0x7F) + 1) times.
+ * Packets never cross lines.  line_offsets gives the start of each line within
+ * data; identical lines may share data, which the rasterizer exploits.
+ */
+struct RleImage {
+  unsigned width;
+  unsigned height;
+  std::uint32_t const *line_offsets;
+  std::uint8_t const *data;
+};
+
+/*
+ * Displays an RleImage, decoding it a line at a time, so that full-resolution
+ * static art costs almost no RAM.  Because each line is found through
+ * line_offsets, the cost of a line is bounded by its own complexity.
+ *
+ * Long runs are filled a word at a time, so flat areas are cheap; a line of
+ * noise costs about as much as copying it twice.
+ *
+ * Optionally, decoded values are indices into a 256-entry palette, e.g. for
+ * fades.
+ */
+class Rle : public Rasterizer {
+public:
+  /*
+   * Creates an Rle displaying 'image' from top_line.  The image is referenced,
+   * not copied.
+   */
+  Rle(RleImage const &image, unsigned top_line = 0);
+
+  RasterInfo rasterize(unsigned, unsigned, Pixel *) override;
+
+  /*
+   * Sets the palette through which decoded values are displayed, or null
+   * (the default) to display them directly.  If video is active this will
+   * take effect at the next line.
+   */
+  void set_palette(Pixel const *palette) { _palette = palette; }
+
+private:
+  RleImage const &_image;
+  unsigned _top_line;
+  Pixel const *_palette;
+};
+
+}  // namespace rast
+}  // namespace vga
+
+#endif  // VGA_RAST_RLE_H
@@ -0,0 +1,21 @@
+#ifndef VGA_RAST_SMMLAR_H
+#define VGA_RAST_SMMLAR_H
+
+#include <cstdint>
+
+namespace vga {
+namespace rast {
+
+/*
+ * Equivalent of the ARMv7-M SMMLAR instruction: the most significant word of
+ * a signed 32x32 product, rounded, plus an accumulator.  Used by the portable
+ * versions of the interpolating kernels to round exactly as the assembly does.
+ */
+inline std::int32_t smmlar(std::int32_t n, std::int32_t m, std::int32_t a) {
+  return a + std::int32_t((std::int64_t(n) * m + 0x80000000) >> 32);
+}
+
+}  // namespace rast
+}  // namespace vga
+
+#endif  // VGA_RAST_SMMLAR_H
@@ -0,0 +1,131 @@
+#include "vga/rast/span_list.h"
+
+#include "etl/assert.h"
+#include "etl/prediction.h"
+
+#include "vga/arena.h"
+#include "vga/rast/fill_pixels.h"
+
+using std::uint16_t;
+
+namespace vga {
+namespace rast {
+
+constexpr uint16_t SpanList::none;
+
+SpanList::SpanList(unsigned width, unsigned height, unsigned capacity,
+                   unsigned top_line)
+  : _width(width),
+    _height(height),
+    _capacity(capacity),
+    _top_line(top_line),
+    _dropped(0),
+    _background(0),
+    _pools{
+      { arena_new_array<Span>(capacity), arena_new_array<uint16_t>(height), 0 },
+      { arena_new_array<Span>(capacity), arena_new_array<uint16_t>(height), 0 },
+    },
+    _page1(false),
+    _flip_pended(false) {
+  ETL_ASSERT(capacity < none);
+
+  for (auto &pool : _pools) {
+    for (unsigned i = 0; i < height; ++i) {
+      pool.heads[i] = none;
+    }
+  }
+}
+
+SpanList::~SpanList() {
+  for (auto &pool : _pools) {
+    pool.spans = nullptr;
+    pool.heads = nullptr;
+  }
+}
+
+void SpanList::clear() {
+  auto &pool = _pools[!_page1];
+  for (unsigned i = 0; i < _height; ++i) {
+    pool.heads[i] = none;
+  }
+  pool.count = 0;
+  _dropped = 0;
+}
+
+bool SpanList::add_span(unsigned line,
+                        unsigned x_start,
+                        unsigned x_end,
+                        Pixel color) {
+  if (x_end > _width) x_end = _width;
+  if (line >= _height || x_start >= x_end) return true;
+
+  auto &pool = _pools[!_page1];
+  if (pool.count == _capacity) {
+    ++_dropped;
+    return false;
+  }
+
+  auto index = uint16_t(pool.count++);
+  auto &span = pool.spans[index];
+  span.x_start = uint16_t(x_start);
+  span.x_end = uint16_t(x_end);
+  span.color = color;
+
+  // Insert after any spans starting at or before this one.
+  auto link = &pool.heads[line];
+  while (*link != none && pool.spans[*link].x_start <= x_start) {
+    link = &pool.spans[*link].next;
+  }
+  span.next = *link;
+  *link = index;
+  return true;
+}
+
+__attribute__((section(".ramcode")))
+Rasterizer::RasterInfo SpanList::rasterize(unsigned cycles_per_pixel,
+                                           unsigned line_number,
+                                           Pixel *target) {
+  line_number -= _top_line;
+  if (ETL_UNLIKELY(line_number == 0)) {
+    if (_flip_pended.exchange(false)) flip_now();
+  } else if (ETL_UNLIKELY(line_number >= _height)) {
+    return { 0, 0, cycles_per_pixel, 0 };
+  }
+
+  auto const &pool = _pools[_page1];
+  unsigned x = 0;
+
+  for (auto i = pool.heads[line_number]; i != none; ) {
+    auto const &span = pool.spans[i];
+    if (span.x_start > x) {
+      fill_pixels_impl(target + x, span.x_start - x, _background);
+    }
+    fill_pixels_impl(target + span.x_start,
+                     span.x_end - span.x_start,
+                     span.color);
+    if (span.x_end > x) x = span.x_end;
+    i = span.next;
+  }
+
+  if (x < _width) {
+    fill_pixels_impl(target + x, _width - x, _background);
+  }
+
+  return {
+    .offset = 0,
+    .length = _width,
+    .cycles_per_pixel = cycles_per_pixel,
+    .repeat_lines = 0,
+  };
+}
+
+void SpanList::pend_flip() {
+  _flip_pended = true;
+}
+
+void SpanList::flip_now() {
+  _page1 = !_page1;
+}
+
+}  // namespace rast
+}  // namespace vga
@@ -0,0 +1,113 @@
+#ifndef VGA_RAST_SPAN_LIST_H
+#define VGA_RAST_SPAN_LIST_H
+
+#include <atomic>
+#include <cstdint>
+
+#include "vga/rasterizer.h"
+
+namespace vga {
+namespace rast {
+
+/*
+ * Draws each line from a list of horizontal spans of solid color, with no
+ * framebuffer.  This suits flat-shaded 3D and vector graphics: the application
+ * scan-converts its shapes into spans during one frame, and they're displayed
+ * during the next.  Memory scales with the complexity of the scene rather
+ * than with resolution, and each span is filled with word stores.
+ *
+ * Spans are kept in two pools, like the pages of a double-buffered bitmap.
+ * The application clears the background pool, adds spans to it in any order,
+ * and calls pend_flip.
+ *
+ * Spans on each line are kept sorted by starting position, and pixels not
+ * covered by any span show the background color.  Spans shouldn't overlap;
+ * where they do, the one starting further right wins.
+ */
+class SpanList : public Rasterizer {
+public:
+  /*
+   * Creates a SpanList producing 'width' pixels by 'height' lines of output,
+   * with room for 'capacity' (less than 65535) spans in each pool.  The pools
+   * are allocated from the arena and start out empty.
+   */
+  SpanList(unsigned width, unsigned height, unsigned capacity,
+           unsigned top_line = 0);
+  ~SpanList();
+
+  RasterInfo rasterize(unsigned, unsigned, Pixel *) override;
+
+  void set_background(Pixel c) { _background = c; }
+
+  /*
+   * Empties the background pool.
+   */
+  void clear();
+
+  /*
+   * Adds a span covering pixels [x_start, x_end) of 'line' to the background
+   * pool.  Spans are clipped to the display.  Returns false, and counts the
+   * span as dropped, if the pool is full.
+   */
+  bool add_span(unsigned line, unsigned x_start, unsigned x_end, Pixel color);
+
+  /*
+   * Returns the number of spans in the background pool.
+   */
+  unsigned get_span_count() const { return _pools[!_page1].count; }
+
+  /*
+   * Returns the number of spans dropped for lack of space since the last
+   * clear.
+   */
+  unsigned get_dropped_count() const { return _dropped; }
+
+  /*
+   * Records that the pools should be swapped, which will happen next time
+   * rasterize is asked to draw the top_line.  Until then (see
+   * is_flip_pended) the background pool must not be altered.
+   */
+  void pend_flip();
+
+  /*
+   * Checks whether a flip requested by pend_flip is still outstanding.
+   */
+  bool is_flip_pended() const { return _flip_pended; }
+
+  /*
+   * Swaps the pools right now.  If video is active this will take effect at
+   * the next line.
+   */
+  void flip_now();
+
+private:
+  struct Span {
+    std::uint16_t x_start;
+    std::uint16_t x_end;
+    std::uint16_t next;     // Index of next span on this line, or 'none'.
+    Pixel color;
+  };
+
+  struct Pool {
+    Span *spans;
+    std::uint16_t *heads;   // Index of first span on each line, or 'none'.
+    unsigned count;
+  };
+
+  static constexpr std::uint16_t none = 0xFFFF;
+
+  unsigned _width;
+  unsigned _height;
+  unsigned _capacity;
+  unsigned _top_line;
+  unsigned _dropped;
+  Pixel _background;
+  Pool _pools[2];
+  bool _page1;
+  std::atomic<bool> _flip_pended;
+};
+
+}  // namespace rast
+}  // namespace vga
+
+#endif  // VGA_RAST_SPAN_LIST_H
@@ -0,0 +1,168 @@
+#include "vga/rast/sprite_overlay.h"
+
+#include "etl/assert.h"
+#include "etl/prediction.h"
+
+#include "vga/arena.h"
+
+using std::uint8_t;
+
+namespace vga {
+namespace rast {
+
+// Rough cost of update_now, for the VblankJob scheduler.
+static constexpr unsigned
+  update_cycles_per_sprite = 64,
+  update_cycles_per_sprite_line = 12;
+
+SpriteOverlay::SpriteOverlay(Rasterizer &inner,
+                             unsigned height,
+                             unsigned sprite_count,
+                             unsigned max_per_line,
+                             unsigned top_line)
+  : _inner(inner),
+    _height(height),
+    _sprite_count(sprite_count),
+    _max_per_line(max_per_line),
+    _top_line(top_line),
+    _dropped(0),
+    _sprites(arena_new_array<Sprite>(sprite_count)),
+    _active(arena_new_array<Sprite>(sprite_count)),
+    _order(arena_new_array<uint8_t>(sprite_count)),
+    _counts(arena_new_array<uint8_t>(height)),
+    _bins(arena_new_array<uint8_t>(height * max_per_line)),
+    _update_job(update_job, this, 0, 0) {
+  ETL_ASSERT(sprite_count <= 255);
+  ETL_ASSERT(max_per_line <= 255);
+
+  for (unsigned i = 0; i < sprite_count; ++i) {
+    _sprites[i] = { nullptr, 0, 0, 0, 0, 0, 0 };
+    _active[i] = _sprites[i];
+  }
+  for (unsigned i = 0; i < height; ++i) {
+    _counts[i] = 0;
+  }
+}
+
+SpriteOverlay::~SpriteOverlay() {
+  _sprites = _active = nullptr;
+  _order = _counts = _bins = nullptr;
+}
+
+void SpriteOverlay::pend_update() {
+  unsigned estimate = 0;
+  for (unsigned i = 0; i < _sprite_count; ++i) {
+    estimate += update_cycles_per_sprite
+              + _sprites[i].height * update_cycles_per_sprite_line;
+  }
+  _update_job.set_estimated_cycles(estimate);
+  submit_vblank_job(_update_job);
+}
+
+void SpriteOverlay::update_job(void *self) {
+  static_cast<SpriteOverlay *>(self)->update_now();
+}
+
+void SpriteOverlay::update_now() {
+  // Take the snapshot and list the visible sprites.
+  unsigned visible = 0;
+  for (unsigned i = 0; i < _sprite_count; ++i) {
+    auto const &s = _active[i] = _sprites[i];
+    if (s.pixels && s.width && s.height
+        && s.y < int(_height) && s.y + int(s.height) > 0) {
+      _order[visible++] = uint8_t(i);
+    }
+  }
+
+  // Sort by descending priority, keeping table order within a priority.
+  // Insertion sort: sprite tables are small and often nearly sorted.
+  for (unsigned i = 1; i < visible; ++i) {
+    auto index = _order[i];
+    auto priority = _active[index].priority;
+    unsigned j = i;
+    for (; j > 0 && _active[_order[j - 1]].priority < priority; --j) {
+      _order[j] = _order[j - 1];
+    }
+    _order[j] = index;
+  }
+
+  // Bin.  Because we go in descending priority, anything that doesn't fit on a
+  // line is lower priority than everything that does.
+  for (unsigned line = 0; line < _height; ++line) {
+    _counts[line] = 0;
+  }
+
+  _dropped = 0;
+  for (unsigned i = 0; i < visible; ++i) {
+    auto index = _order[i];
+    auto const &s = _active[index];
+
+    unsigned first = s.y < 0 ? 0 : unsigned(s.y);
+    unsigned end = unsigned(s.y + int(s.height));
+    if (end > _height) end = _height;
+
+    for (unsigned line = first; line < end; ++line) {
+      auto &count = _counts[line];
+      if (count == _max_per_line) {
+        ++_dropped;
+        continue;
+      }
+      _bins[line * _max_per_line + count] = index;
+      ++count;
+    }
+  }
+}
+
+__attribute__((section(".ramcode")))
+void SpriteOverlay::composite(uint8_t const *bin,
+                              unsigned count,
+                              unsigned line,
+                              Pixel *target,
+                              unsigned length) const {
+  // Bins are in descending priority; draw from the bottom up.
+  while (count--) {
+    auto const &s = _active[bin[count]];
+    auto src = s.pixels + (int(line) - s.y) * s.width;
+
+    int start = s.x < 0 ? -s.x : 0;
+    int end = s.width;
+    if (s.x + end > int(length)) end = int(length) - s.x;
+
+    auto key = s.key;
+    for (int i = start; i < end; ++i) {
+      auto p = src[i];
+      if (p != key) target[s.x + i] = p;
+    }
+  }
+}
+
+__attribute__((section(".ramcode")))
+Rasterizer::RasterInfo SpriteOverlay::rasterize(unsigned cycles_per_pixel,
+                                                unsigned line_number,
+                                                Pixel *target) {
+  auto result = _inner.rasterize(cycles_per_pixel, line_number, target);
+
+  line_number -= _top_line;
+  if (ETL_UNLIKELY(line_number >= _height)) return result;
+
+  unsigned count = _counts[line_number];
+  if (count) {
+    composite(&_bins[line_number * _max_per_line], count,
+              line_number, target, result.length);
+    // Sprites may differ on the next line.
+    result.repeat_lines = 0;
+  } else {
+    // Don't let the inner rasterizer's repeats cover up a sprite.
+    for (unsigned i = 1; i <= result.repeat_lines; ++i) {
+      if (line_number + i < _height && _counts[line_number + i]) {
+        result.repeat_lines = i - 1;
+        break;
+      }
+    }
+  }
+
+  return result;
+}
+
+}  // namespace rast
+}  // namespace vga
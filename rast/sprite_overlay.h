@@ -0,0 +1,116 @@
+#ifndef VGA_RAST_SPRITE_OVERLAY_H
+#define VGA_RAST_SPRITE_OVERLAY_H
+
+#include <cstdint>
+
+#include "vga/rasterizer.h"
+#include "vga/vblank.h"
+
+namespace vga {
+namespace rast {
+
+/*
+ * Draws sprites over the output of another Rasterizer, so that moving objects
+ * don't require redrawing a framebuffer.
+ *
+ * The application edits a table of Sprites and calls pend_update; at the next
+ * vertical blank, the overlay takes a snapshot of the table and sorts the
+ * visible sprites into per-line lists.  While rasterizing, it composites the
+ * sprites on each line into the inner Rasterizer's output.
+ *
+ * Sprite coordinates are in the inner Rasterizer's output pixels (so if it
+ * doubles pixels horizontally, so do the sprites) and in display lines counted
+ * from top_line.  Sprites are clipped to the inner Rasterizer's output.
+ *
+ * Lines are limited to max_per_line sprites, to bound the time spent on each;
+ * beyond that, sprites of lowest priority are dropped from the line.
+ */
+class SpriteOverlay : public Rasterizer {
+public:
+  struct Sprite {
+    Pixel const *pixels;    // width * height pixels, by rows; null hides.
+    int x;
+    int y;
+    std::uint16_t width;
+    std::uint16_t height;
+    Pixel key;              // Pixels of this color are transparent.
+    std::uint8_t priority;  // Higher priorities are drawn on top.
+  };
+
+  /*
+   * Creates a SpriteOverlay on top of 'inner' covering 'height' lines, with
+   * 'sprite_count' (at most 255) sprites, initially hidden.  Tables are
+   * allocated from the arena.
+   */
+  SpriteOverlay(Rasterizer &inner,
+                unsigned height,
+                unsigned sprite_count,
+                unsigned max_per_line,
+                unsigned top_line = 0);
+  ~SpriteOverlay();
+
+  RasterInfo rasterize(unsigned, unsigned, Pixel *) override;
+
+  unsigned get_sprite_count() const { return _sprite_count; }
+
+  /*
+   * Accesses the application's copy of the sprite table.  Changes aren't
+   * displayed until the next pend_update or update_now, and mustn't be made
+   * while an update is pended.
+   */
+  Sprite &get_sprite(unsigned index) { return _sprites[index]; }
+  Sprite const &get_sprite(unsigned index) const { return _sprites[index]; }
+
+  /*
+   * Arranges for the sprite table to be displayed from the next frame, using a
+   * VblankJob.  Until then (see is_update_pended) the table must not be
+   * altered, as the snapshot may be taken at any point in vertical blank.
+   */
+  void pend_update();
+
+  /*
+   * Checks whether an update requested by pend_update is still outstanding.
+   */
+  bool is_update_pended() const { return _update_job.is_queued(); }
+
+  /*
+   * Displays the sprite table right now.  Only safe if this rasterizer isn't
+   * in use by the driver, or from a VblankJob.
+   */
+  void update_now();
+
+  /*
+   * Returns the number of sprites dropped from lines by the last update, due
+   * to max_per_line.
+   */
+  unsigned get_dropped_count() const { return _dropped; }
+
+private:
+  Rasterizer &_inner;
+  unsigned _height;
+  unsigned _sprite_count;
+  unsigned _max_per_line;
+  unsigned _top_line;
+  unsigned _dropped;
+
+  Sprite *_sprites;         // Application's copy.
+  Sprite *_active;          // Snapshot being displayed.
+  std::uint8_t *_order;     // Sprite indices, by descending priority.
+  std::uint8_t *_counts;    // Sprites on each line.
+  std::uint8_t *_bins;      // _max_per_line sprite indices for each line.
+
+  VblankJob _update_job;
+
+  static void update_job(void *);
+
+  void composite(std::uint8_t const *bin,
+                 unsigned count,
+                 unsigned line,
+                 Pixel *target,
+                 unsigned length) const;
+};
+
+}  // namespace rast
+}  // namespace vga
+
+#endif  // VGA_RAST_SPRITE_OVERLAY_H
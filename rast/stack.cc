@@ -0,0 +1,72 @@
+#include "vga/rast/stack.h"
+
+#include "vga/arena.h"
+#include "vga/rast/fill_pixels.h"
+#include "vga/rast/merge_keyed.h"
+#include "vga/rast/stretch.h"
+
+namespace vga {
+namespace rast {
+
+// Layers may draw a little outside their lines; pad the scratch buffer to
+// allow for it.
+static constexpr unsigned scratch_pad = Rasterizer::max_overrun;
+
+Stack::Stack(unsigned width, Layer const *front, Pixel key)
+  : _width(width),
+    _front(front),
+    _key(key),
+    _scratch(arena_new_array<Pixel>(width + 2 * scratch_pad) + scratch_pad) {}
+
+Stack::~Stack() {
+  _front = nullptr;
+  _scratch = nullptr;
+}
+
+__attribute__((section(".ramcode")))
+Rasterizer::RasterInfo Stack::rasterize(unsigned cycles_per_pixel,
+                                        unsigned line_number,
+                                        Pixel *target) {
+  fill_pixels_impl(target, _width, _key);
+
+  RasterInfo result { 0, _width, cycles_per_pixel, ~0u };
+
+  for (auto layer = _front; layer; layer = layer->next) {
+    auto info = layer->rasterizer->rasterize(cycles_per_pixel,
+                                             line_number,
+                                             _scratch);
+    if (info.repeat_lines < result.repeat_lines) {
+      result.repeat_lines = info.repeat_lines;
+    }
+
+    // Bring coarser layers to our scale, without running off the line.
+    unsigned length = info.length;
+    unsigned factor = info.cycles_per_pixel / cycles_per_pixel;
+    if (factor > 1) {
+      int room = int(_width) - (info.offset > 0 ? info.offset : 0);
+      if (room <= 0) continue;
+      length = stretch_pixels(_scratch, length, factor, unsigned(room));
+    }
+
+    // Clip the layer's output to the line.
+    int start = info.offset;
+    int end = info.offset + int(length);
+    Pixel const *src = _scratch;
+    if (start < 0) {
+      src -= start;
+      start = 0;
+    }
+    if (end > int(_width)) end = int(_width);
+    if (start >= end) continue;
+
+    merge_keyed_impl(target + start, src, unsigned(end - start), _key);
+
+    if (layer->opaque && start == 0 && end == int(_width)) break;
+  }
+
+  if (result.repeat_lines == ~0u) result.repeat_lines = 0;
+  return result;
+}
+
+}  // namespace rast
+}  // namespace vga
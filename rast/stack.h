@@ -0,0 +1,68 @@
+#ifndef VGA_RAST_STACK_H
+#define VGA_RAST_STACK_H
+
+#include "vga/rasterizer.h"
+
+namespace vga {
+namespace rast {
+
+/*
+ * Composites several Rasterizers on the same lines, e.g. a HUD over a
+ * playfield, without any of them knowing.
+ *
+ * Layers are listed front to back.  On each line, the Stack rasterizes each
+ * layer into a scratch buffer and merges it in, filling only those pixels that
+ * are still transparent -- that is, equal to the key color.  Pixels outside
+ * the range a layer reports (its offset and length) are transparent too.
+ * Whatever is still transparent after the last layer is displayed in the key
+ * color.
+ *
+ * A layer marked opaque promises never to produce the key color.  When an
+ * opaque layer covers the whole line, the layers behind it aren't rasterized
+ * at all on that line.  Layers skipped in this way miss calls to rasterize, so
+ * any state they update in rasterize (e.g. pended flips at their top line)
+ * may be delayed.
+ *
+ * Layers may produce coarser pixels than the Stack, by returning a multiple
+ * of the cycles_per_pixel they're given (as Palette8 does when scaled, or
+ * SolidColor always); the Stack stretches them to its own scale, which costs
+ * a fill per layer pixel.  (Such layers are clipped to the Stack's width
+ * measured from where they start, so a negative offset loses pixels on the
+ * right.)  A layer's repeat_lines is respected by rasterizing
+ * the whole Stack less often.
+ */
+class Stack : public Rasterizer {
+public:
+  struct Layer {
+    Rasterizer *rasterizer;
+    bool opaque;            // Never produces the key color.
+    Layer const *next;      // Next layer back, or null.
+  };
+
+  /*
+   * Creates a Stack producing 'width' pixels from the layers starting at
+   * 'front', using 'key' as the transparent color.  A scratch line buffer is
+   * allocated from the arena.
+   */
+  Stack(unsigned width, Layer const *front, Pixel key);
+  ~Stack();
+
+  RasterInfo rasterize(unsigned, unsigned, Pixel *) override;
+
+  /*
+   * Changes the list of layers.  If video is active this will take effect at
+   * the next line.
+   */
+  void set_layers(Layer const *front) { _front = front; }
+
+private:
+  unsigned _width;
+  Layer const *_front;
+  Pixel _key;
+  Pixel *_scratch;
+};
+
+}  // namespace rast
+}  // namespace vga
+
+#endif  // VGA_RAST_STACK_H
@@ -0,0 +1,29 @@
+#include "vga/rast/stretch.h"
+
+#include "vga/rast/fill_pixels.h"
+
+namespace vga {
+namespace rast {
+
+__attribute__((section(".ramcode")))
+unsigned stretch_pixels(Rasterizer::Pixel *buffer,
+                        unsigned count,
+                        unsigned factor,
+                        unsigned limit) {
+  if (count > (limit + factor - 1) / factor) {
+    count = (limit + factor - 1) / factor;
+  }
+  if (count == 0) return 0;
+
+  // Work backwards so that we never overwrite a pixel before reading it.
+  unsigned last = limit - (count - 1) * factor;
+  if (last > factor) last = factor;
+  fill_pixels_impl(buffer + (count - 1) * factor, last, buffer[count - 1]);
+  for (unsigned i = count - 1; i-- > 0; ) {
+    fill_pixels_impl(buffer + i * factor, factor, buffer[i]);
+  }
+  return (count - 1) * factor + last;
+}
+
+}  // namespace rast
+}  // namespace vga
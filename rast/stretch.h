@@ -0,0 +1,25 @@
+#ifndef VGA_RAST_STRETCH_H
+#define VGA_RAST_STRETCH_H
+
+#include "vga/rasterizer.h"
+
+namespace vga {
+namespace rast {
+
+/*
+ * Stretches the first 'count' pixels of 'buffer' by an integer 'factor', in
+ * place, producing at most 'limit' pixels.  Returns the number produced.
+ *
+ * This is how compositing rasterizers bring the output of a rasterizer that
+ * asked for wide pixels (by returning a multiple of the cycles_per_pixel it
+ * was given) to the scale of its neighbors.
+ */
+unsigned stretch_pixels(Rasterizer::Pixel *buffer,
+                        unsigned count,
+                        unsigned factor,
+                        unsigned limit);
+
+}  // namespace rast
+}  // namespace vga
+
+#endif  // VGA_RAST_STRETCH_H
@@ -0,0 +1,210 @@
+#include "vga/rast/text.h"
+
+#include "etl/assert.h"
+#include "etl/prediction.h"
+
+#include "vga/arena.h"
+#include "vga/timing.h"
+#include "vga/vga.h"
+#include "vga/rast/unpack_text_10p_attributed.h"
+#include "vga/rast/unpack_text_6p_attributed.h"
+#include "vga/rast/unpack_text_8p_attributed.h"
+
+namespace vga {
+namespace rast {
+
+using UnpackKernel = void (*)(void const *,
+                              unsigned char const *,
+                              unsigned char *,
+                              unsigned,
+                              unsigned);
+
+// Chooses the unpack kernel for a cell width, or null if there isn't one.
+static constexpr UnpackKernel kernel_for_width(unsigned width) {
+  return width == 10 ? unpack_text_10p_attributed_impl
+       : width == 8 ? unpack_text_8p_attributed_impl
+       : width == 6 ? unpack_text_6p_attributed_impl
+       : nullptr;
+}
+
+template <unsigned W, unsigned H>
+Text<W, H>::Text(std::uint8_t const * font,
+                 unsigned chars_in_font,
+                 unsigned width,
+                 unsigned height,
+                 unsigned top_line,
+                 bool hide_right)
+  : _cols((width + (W - 1)) / W),
+    _rows((height + (H - 1)) / H),
+    _full_rows(height / H),
+    _ring_rows(_rows + 1),
+    _chars_in_font(chars_in_font),
+    _top_line(top_line),
+    _hide_right(hide_right),
+    _x_adj(0),
+    _underline_row(H - 2),
+    _blink_period(30),
+    _origin(0),
+    _fine(0),
+    _scroll_y(0),
+    _pending_y(0),
+    _scroll_pended(false),
+    _scroll_frame(~0u),
+    _font(arena_new_array<std::uint8_t>(chars_in_font * H)),
+    _fb(arena_new_array<std::uint32_t>(_cols * _ring_rows)) {
+  // Copy font into RAM for fast deterministic access.
+  for (unsigned i = 0; i < chars_in_font * H; ++i) {
+    _font[i] = font[i];
+  }
+}
+
+template <unsigned W, unsigned H>
+Text<W, H>::~Text() {
+  _font = nullptr;
+  _fb = nullptr;
+  _cols = 0;
+}
+
+template <unsigned W, unsigned H>
+__attribute__((section(".ramcode")))
+Rasterizer::RasterInfo Text<W, H>::rasterize(unsigned cycles_per_pixel,
+                                             unsigned line_number,
+                                             Pixel *raster_target) {
+  constexpr auto kernel = kernel_for_width(W);
+  static_assert(kernel != nullptr, "no unpack kernel for this cell width");
+
+  // Apply any pended scroll on the first line asked for in each frame, which
+  // needn't be _top_line: the band may start below it.
+  unsigned frame = get_frame_count();
+  if (ETL_UNLIKELY(frame != _scroll_frame)) {
+    _scroll_frame = frame;
+    if (_scroll_pended.exchange(false)) _scroll_y = _pending_y;
+  }
+
+  line_number -= _top_line;
+  if (ETL_UNLIKELY(line_number >= _rows * H)) {
+    return { 0, 0, cycles_per_pixel, 0 };
+  }
+
+  unsigned ring_line = line_number + _scroll_y;
+  if (ring_line >= _ring_rows * H) ring_line -= _ring_rows * H;
+
+  unsigned text_row = ring_line / H;
+  unsigned row_in_glyph = ring_line % H;
+
+  std::uint32_t const *src = _fb + _cols * text_row;
+  std::uint8_t const *font = _font + row_in_glyph * _chars_in_font;
+
+  std::uint8_t bg = *src >> 8;
+  for (int i = 0; i < _x_adj; ++i) raster_target[i] = bg;
+
+  bg = *(src + _cols - 1) >> 8;
+  for (int i = _cols * W + _x_adj; i < int(_cols * W); ++i) {
+    raster_target[i] = bg;
+  }
+
+  // Decide which attributes have any effect on this line.
+  unsigned attributes = inverse;
+  if (row_in_glyph == _underline_row) attributes |= underline;
+  if (_blink_period && (frame / _blink_period) % 2) {
+    attributes |= blink;
+  }
+
+  if (_glyph_cache) {
+    _glyph_cache->unpack(src, font, raster_target + _x_adj, _cols,
+                         attributes << 24);
+  } else {
+    kernel(src, font, raster_target + _x_adj, _cols, attributes << 24);
+  }
+
+  return {
+    .offset = 0,
+    .length = _cols * W - (_hide_right * W),
+    .cycles_per_pixel = cycles_per_pixel,
+    .repeat_lines = 0,
+  };
+}
+
+template <unsigned W, unsigned H>
+void Text<W, H>::enable_glyph_cache(unsigned color_pairs) {
+  ETL_ASSERT(!_glyph_cache);
+  _glyph_cache = arena_make<GlyphCache>(color_pairs, W);
+}
+
+template <unsigned W, unsigned H>
+GlyphCache::Stats Text<W, H>::get_glyph_cache_stats() const {
+  if (_glyph_cache) return _glyph_cache->get_stats();
+  return {};
+}
+
+template <unsigned W, unsigned H>
+void Text<W, H>::reset_glyph_cache_stats() {
+  if (_glyph_cache) _glyph_cache->reset_stats();
+}
+
+template <unsigned W, unsigned H>
+void Text<W, H>::clear_framebuffer(Pixel bg) {
+  unsigned word = bg << 8 | ' ';
+  for (unsigned i = 0; i < _cols * _ring_rows; ++i) {
+    _fb[i] = word;
+  }
+}
+
+template <unsigned W, unsigned H>
+void Text<W, H>::clear_row(unsigned row, Pixel bg) {
+  unsigned word = bg << 8 | ' ';
+  auto cells = get_row_cells(row);
+  for (unsigned i = 0; i < _cols; ++i) {
+    cells[i] = word;
+  }
+}
+
+template <unsigned W, unsigned H>
+void Text<W, H>::scroll(unsigned rows) {
+  _origin = (_origin + rows) % _ring_rows;
+  _fine = 0;
+  pend_scroll();
+}
+
+template <unsigned W, unsigned H>
+void Text<W, H>::set_fine_scroll(unsigned lines) {
+  ETL_ASSERT(lines < H);
+  _fine = lines;
+  pend_scroll();
+}
+
+template <unsigned W, unsigned H>
+void Text<W, H>::pend_scroll() {
+  _pending_y = _origin * H + _fine;
+  _scroll_pended = true;
+}
+
+template <unsigned W, unsigned H>
+std::uint32_t *Text<W, H>::get_row_cells(unsigned row) const {
+  row += _origin;
+  if (row >= _ring_rows) row -= _ring_rows;
+  return _fb + row * _cols;
+}
+
+template <unsigned W, unsigned H>
+void Text<W, H>::put_char(unsigned col, unsigned row,
+                          Pixel fore, Pixel back,
+                          char c,
+                          std::uint8_t attributes) {
+  put_packed(col, row,
+             (attributes << 24) | (fore << 16) | (back << 8) | std::uint8_t(c));
+}
+
+template <unsigned W, unsigned H>
+void Text<W, H>::put_packed(unsigned col, unsigned row,
+                            unsigned p) {
+  get_row_cells(row)[col] = p;
+}
+
+template class Text<10, 16>;
+template class Text<8, 16>;
+template class Text<8, 8>;
+template class Text<6, 12>;
+
+}  // namespace rast
+}  // namespace vga
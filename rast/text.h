@@ -0,0 +1,185 @@
+#ifndef VGA_RAST_TEXT_H
+#define VGA_RAST_TEXT_H
+
+#include <atomic>
+#include <cstdint>
+
+#include "vga/arena.h"
+#include "vga/rasterizer.h"
+#include "vga/rast/glyph_cache.h"
+
+namespace vga {
+namespace rast {
+
+/*
+ * Rasterizes 256-color text with per-character colors and attributes, in
+ * character cells CellWidth pixels wide and CellHeight lines tall.
+ *
+ * Fonts hold CellHeight rows of eight bits for each glyph, stored row-normal
+ * (see unpack_text_10p_attributed.S).  Cells wider than eight pixels add a
+ * background-colored gutter on the right; narrower cells show only the
+ * glyph's leftmost (least significant) bits, so fonts for them should include
+ * their own spacing.
+ *
+ * Each cell width has its own unpack kernel, chosen at compile time; there
+ * are kernels for widths 10, 8, and 6, and any height works.  The sizes
+ * aliased below are instantiated in text.cc; add others there.
+ *
+ * The framebuffer is a ring of rows, one more than are displayed, so that
+ * scrolling moves the ring's origin instead of the text.  Rows are numbered
+ * from the origin; the extra row, numbered get_row_count(), sits just below
+ * the display, where fine scrolling brings it into view.
+ */
+template <unsigned CellWidth, unsigned CellHeight>
+class Text : public Rasterizer {
+public:
+  static constexpr unsigned cell_width = CellWidth;
+  static constexpr unsigned cell_height = CellHeight;
+
+  /*
+   * Character attributes, which may be combined.  These are applied while
+   * rasterizing, so e.g. blinking costs no framebuffer writes.
+   */
+  enum Attribute : std::uint8_t {
+    inverse = 1 << 0,     // Swap foreground and background colors.
+    underline = 1 << 1,   // Fill the underline row with foreground color.
+    blink = 1 << 2,       // Periodically show only background color.
+  };
+
+  Text(std::uint8_t const * font,
+       unsigned chars_in_font,
+       unsigned width, unsigned height,
+       unsigned top_line = 0,
+       bool hide_right = false);
+  ~Text();
+
+  unsigned get_col_count() const { return _cols; }
+  unsigned get_row_count() const { return _rows; }
+
+  /*
+   * Returns the number of rows shown in full.  This is one less than
+   * get_row_count when the height isn't a multiple of CellHeight, and the
+   * last row is cut off.
+   */
+  unsigned get_full_row_count() const { return _full_rows; }
+
+  RasterInfo rasterize(unsigned, unsigned, Pixel *) override;
+
+  void clear_framebuffer(Pixel);
+
+  void put_char(unsigned col, unsigned row,
+                Pixel fore, Pixel back,
+                char c,
+                std::uint8_t attributes = 0);
+  void put_packed(unsigned col, unsigned row, unsigned p);
+
+  /*
+   * Returns the cells of a row (which may be the row below the display), in
+   * the format of put_packed, for writing many at once.  Valid until the
+   * next scroll.
+   */
+  std::uint32_t *get_row_cells(unsigned row) const;
+
+  /*
+   * Fills a row (which may be the row below the display) with spaces in the
+   * given background color.
+   */
+  void clear_row(unsigned row, Pixel);
+
+  /*
+   * Scrolls the text up by 'rows' rows by moving the ring's origin, which
+   * costs the same however much text there is, and resets fine scrolling.
+   * Takes effect at the top of the next frame.
+   *
+   * Rows scrolled in at the bottom still hold whatever was there before --
+   * first the row below the display, then rows that scrolled off the top --
+   * so clear or fill them.  While fine scrolling is zero, and no earlier
+   * scroll is still waiting for the next frame, scrolling a single row then
+   * clearing the new bottom row doesn't disturb the frame being displayed,
+   * because that row is the one hidden below it.  Otherwise the rows being
+   * cleared may be on screen until the frame ends.
+   */
+  void scroll(unsigned rows = 1);
+
+  /*
+   * Shifts the text up by 'lines' (less than CellHeight) display lines, so
+   * the top row is partly hidden and the row below the display partly
+   * shown.  Stepping this from 0 to CellHeight-1, frame by frame, and then
+   * calling scroll gives smooth scrolling.  Takes effect at the top of the
+   * next frame.
+   */
+  void set_fine_scroll(unsigned lines);
+
+  /*
+   * Checks whether a scroll or fine scroll is still waiting for the next
+   * frame, in which case the frame being displayed predates it.
+   */
+  bool is_scroll_pending() const { return _scroll_pended; }
+
+  void set_x_adj(int v) { _x_adj = v; }
+  void set_top_line(unsigned top_line) { _top_line = top_line; }
+
+  /*
+   * Sets the row of each glyph, counting from zero at the top, that is filled
+   * for underlined characters.  Defaults to the second-to-last row.
+   */
+  void set_underline_row(unsigned row) { _underline_row = row; }
+
+  /*
+   * Sets the number of frames that blinking characters spend visible, and
+   * then hidden.  Zero stops blinking, leaving them visible.  Defaults to 30.
+   */
+  void set_blink_period(unsigned frames) { _blink_period = frames; }
+
+  /*
+   * Switches to drawing through a GlyphCache with room for 'color_pairs' (at
+   * least one) foreground/background pairs, allocated from the arena.  This
+   * can only be done once.  Check get_glyph_cache_stats to see whether it's
+   * paying off.
+   */
+  void enable_glyph_cache(unsigned color_pairs);
+
+  /*
+   * Returns the glyph cache's statistics, or zeroes if it isn't enabled.
+   */
+  GlyphCache::Stats get_glyph_cache_stats() const;
+  void reset_glyph_cache_stats();
+
+private:
+  unsigned _cols;
+  unsigned _rows;
+  unsigned _full_rows;
+  unsigned _ring_rows;
+  unsigned _chars_in_font;
+  unsigned _top_line;
+  bool _hide_right;
+  int _x_adj;
+  unsigned _underline_row;
+  unsigned _blink_period;
+  unsigned _origin;         // Ring row shown at the top, for the application.
+  unsigned _fine;
+  unsigned _scroll_y;       // Ring line shown at the top, for rasterization.
+  unsigned _pending_y;
+  std::atomic<bool> _scroll_pended;
+  unsigned _scroll_frame;   // Frame in which a pended scroll was last checked.
+  std::uint8_t * _font;
+  std::uint32_t * _fb;
+  ArenaPtr<GlyphCache> _glyph_cache;
+
+  void pend_scroll();
+};
+
+extern template class Text<10, 16>;
+extern template class Text<8, 16>;
+extern template class Text<8, 8>;
+extern template class Text<6, 12>;
+
+using Text_10x16 = Text<10, 16>;
+using Text_8x16 = Text<8, 16>;
+using Text_8x8 = Text<8, 8>;
+using Text_6x12 = Text<6, 12>;
+
+}  // namespace rast
+}  // namespace vga
+
+#endif  // VGA_RAST_TEXT_H
@@ -0,0 +1,100 @@
+#include "vga/rast/tilemap_8x8.h"
+
+#include "etl/prediction.h"
+
+#include "vga/arena.h"
+#include "vga/rast/unpack_tile8.h"
+
+using std::uint8_t;
+
+namespace vga {
+namespace rast {
+
+Tilemap_8x8::Tilemap_8x8(unsigned width, unsigned height,
+                         unsigned map_cols, unsigned map_rows,
+                         unsigned tile_count,
+                         unsigned top_line)
+  : _width(width),
+    _height(height),
+    _map_cols(map_cols),
+    _map_rows(map_rows),
+    _tile_count(tile_count),
+    _top_line(top_line),
+    _scroll_x(0),
+    _scroll_y(0),
+    _pending_x(0),
+    _pending_y(0),
+    _scroll_pended(false),
+    _map(arena_new_array<uint8_t>(map_cols * map_rows)),
+    _patterns(arena_new_array<Pixel>(tile_count * 64)) {
+  for (unsigned i = 0; i < map_cols * map_rows; ++i) {
+    _map[i] = 0;
+  }
+  for (unsigned i = 0; i < tile_count * 64; ++i) {
+    _patterns[i] = 0;
+  }
+}
+
+Tilemap_8x8::~Tilemap_8x8() {
+  _map = nullptr;
+  _patterns = nullptr;
+}
+
+__attribute__((section(".ramcode")))
+Rasterizer::RasterInfo Tilemap_8x8::rasterize(unsigned cycles_per_pixel,
+                                              unsigned line_number,
+                                              Pixel *target) {
+  line_number -= _top_line;
+  if (ETL_UNLIKELY(line_number == 0)) {
+    if (_scroll_pended.exchange(false)) {
+      _scroll_x = _pending_x;
+      _scroll_y = _pending_y;
+    }
+  } else if (ETL_UNLIKELY(line_number >= _height)) {
+    return { 0, 0, cycles_per_pixel, 0 };
+  }
+
+  unsigned map_y = (line_number + _scroll_y) % (_map_rows * 8);
+  unsigned map_x = _scroll_x % (_map_cols * 8);
+
+  uint8_t const *map_row = _map + (map_y / 8) * _map_cols;
+  Pixel const *patterns = _patterns + (map_y % 8) * 8;
+
+  // Start drawing up to 7 pixels to the left of the target, into the working
+  // buffer's padding, so that whole tiles land at the fine scroll position.
+  // We may likewise overrun the right edge by up to 7 pixels.
+  unsigned fine = map_x % 8;
+  unsigned col = map_x / 8;
+  unsigned tiles = (fine + _width + 7) / 8;
+  Pixel *out = target - fine;
+
+  while (tiles) {
+    unsigned run = _map_cols - col;
+    if (run > tiles) run = tiles;
+    unpack_tile8_impl(map_row + col, patterns, out, run);
+    out += run * 8;
+    tiles -= run;
+    col = 0;
+  }
+
+  return {
+    .offset = 0,
+    .length = _width,
+    .cycles_per_pixel = cycles_per_pixel,
+    .repeat_lines = 0,
+  };
+}
+
+void Tilemap_8x8::pend_scroll(unsigned x, unsigned y) {
+  _pending_x = x;
+  _pending_y = y;
+  _scroll_pended = true;
+}
+
+void Tilemap_8x8::scroll_now(unsigned x, unsigned y) {
+  _scroll_x = x;
+  _scroll_y = y;
+}
+
+}  // namespace rast
+}  // namespace vga
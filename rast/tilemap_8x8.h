@@ -0,0 +1,83 @@
+#ifndef VGA_RAST_TILEMAP_8X8_H
+#define VGA_RAST_TILEMAP_8X8_H
+
+#include <atomic>
+#include <cstdint>
+
+#include "vga/rasterizer.h"
+
+namespace vga {
+namespace rast {
+
+/*
+ * Draws a scrolling playfield from a map of 8x8-pixel tiles.
+ *
+ * The map holds one byte per tile, naming one of up to 256 tile patterns; each
+ * pattern is 64 bytes of pixels, by rows.  A 100x75-tile map covering an
+ * 800x600 display thus costs 7.5 KiB plus 64 bytes per distinct tile, instead
+ * of the 469 KiB of a direct-color framebuffer.
+ *
+ * The display scrolls across the map to any pixel position, wrapping around
+ * at the map's edges in both directions.
+ */
+class Tilemap_8x8 : public Rasterizer {
+public:
+  /*
+   * Creates a Tilemap_8x8 producing 'width' pixels by 'height' lines of
+   * output, from a map of 'map_cols' by 'map_rows' tiles using 'tile_count'
+   * patterns.  The map and patterns are allocated from the arena and zeroed.
+   */
+  Tilemap_8x8(unsigned width, unsigned height,
+              unsigned map_cols, unsigned map_rows,
+              unsigned tile_count,
+              unsigned top_line = 0);
+  ~Tilemap_8x8();
+
+  RasterInfo rasterize(unsigned, unsigned, Pixel *) override;
+
+  unsigned get_map_cols() const { return _map_cols; }
+  unsigned get_map_rows() const { return _map_rows; }
+  unsigned get_tile_count() const { return _tile_count; }
+
+  /*
+   * The map, by rows of get_map_cols() tile numbers.
+   */
+  std::uint8_t *get_map() const { return _map; }
+
+  /*
+   * The pattern of a tile: 8 rows of 8 pixels.
+   */
+  Pixel *get_tile(unsigned index) const { return _patterns + index * 64; }
+
+  /*
+   * Records a new scroll position -- the map pixel shown at the top left of
+   * the display -- to take effect at the top of the next frame.
+   */
+  void pend_scroll(unsigned x, unsigned y);
+
+  /*
+   * Scrolls immediately.  If video is active this will take effect at the next
+   * line, which is useful from a CopperOp for split-screen effects.
+   */
+  void scroll_now(unsigned x, unsigned y);
+
+private:
+  unsigned _width;
+  unsigned _height;
+  unsigned _map_cols;
+  unsigned _map_rows;
+  unsigned _tile_count;
+  unsigned _top_line;
+  unsigned _scroll_x;
+  unsigned _scroll_y;
+  unsigned _pending_x;
+  unsigned _pending_y;
+  std::atomic<bool> _scroll_pended;
+  std::uint8_t *_map;
+  Pixel *_patterns;
+};
+
+}  // namespace rast
+}  // namespace vga
+
+#endif  // VGA_RAST_TILEMAP_8X8_H
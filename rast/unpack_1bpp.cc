@@ -0,0 +1,58 @@
+#include "vga/rast/unpack_1bpp.h"
+
+using std::uint8_t;
+using std::uint32_t;
+
+namespace vga {
+namespace rast {
+
+/*
+ * Portable equivalent of unpack_1bpp.S.
+ *
+ * Each input word holds 32 pixels, least significant bit leftmost.  A zero bit
+ * selects clut[0] and a one bit selects clut[1].
+ */
+__attribute__((section(".ramcode")))
+void unpack_1bpp_impl(uint32_t const *input_line,
+                      uint8_t const *clut,
+                      uint8_t *render_target,
+                      unsigned words_in_input) {
+  uint8_t const c0 = clut[0], c1 = clut[1];
+
+  for (unsigned w = 0; w < words_in_input; ++w) {
+    uint32_t bits = *input_line++;
+    for (unsigned i = 0; i < 32; ++i) {
+      render_target[i] = (bits & 1) ? c1 : c0;
+      bits >>= 1;
+    }
+    render_target += 32;
+  }
+}
+
+/*
+ * Portable equivalent of unpack_1bpp_overlay.S.
+ *
+ * As unpack_1bpp_impl, except that zero bits are transparent: they select the
+ * corresponding pixel from the background line instead of clut[0].
+ */
+__attribute__((section(".ramcode")))
+void unpack_1bpp_overlay_impl(uint32_t const *input_line,
+                              uint8_t const *clut,
+                              uint8_t *render_target,
+                              unsigned words_in_input,
+                              uint8_t const *background) {
+  uint8_t const c1 = clut[1];
+
+  for (unsigned w = 0; w < words_in_input; ++w) {
+    uint32_t bits = *input_line++;
+    for (unsigned i = 0; i < 32; ++i) {
+      render_target[i] = (bits & 1) ? c1 : background[i];
+      bits >>= 1;
+    }
+    render_target += 32;
+    background += 32;
+  }
+}
+
+}  // namespace rast
+}  // namespace vga
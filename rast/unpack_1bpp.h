@@ -6,11 +6,23 @@
 namespace vga {
 namespace rast {
 
+/*
+ * 1bpp unpackers.  Each input word holds 32 pixels, least significant bit
+ * leftmost, selecting clut[0] or clut[1].
+ *
+ * 'words_in_input' must be nonzero: the assembly versions test the count at
+ * the bottom of the loop, and so process one word when given zero.
+ */
+
 void unpack_1bpp_impl(std::uint32_t const *input_line,
                       std::uint8_t const *clut,
                       std::uint8_t *render_target,
                       unsigned words_in_input);
 
+/*
+ * As unpack_1bpp_impl, but zero bits show the corresponding pixels of
+ * 'background' instead of clut[0].
+ */
 void unpack_1bpp_overlay_impl(std::uint32_t const *input_line,
                               std::uint8_t const *clut,
                               std::uint8_t *render_target,
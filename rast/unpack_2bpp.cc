@@ -0,0 +1,60 @@
+#include "vga/rast/unpack_2bpp.h"
+
+#include <cstring>
+
+using std::uint8_t;
+using std::uint32_t;
+
+namespace vga {
+namespace rast {
+
+/*
+ * Portable equivalent of unpack_2bpp.S.
+ *
+ * Each input word holds 16 pixels, least significant bits leftmost.  Each byte
+ * of input, four pixels, indexes the lookup table to produce a word of output.
+ */
+__attribute__((section(".ramcode")))
+void unpack_2bpp_impl(uint32_t const *input_line,
+                      uint32_t const *lut,
+                      uint8_t *render_target,
+                      unsigned words_in_input) {
+  for (unsigned w = 0; w < words_in_input; ++w) {
+    uint32_t bits = *input_line++;
+    for (unsigned i = 0; i < 4; ++i) {
+      uint32_t px = lut[bits & 0xFF];
+      std::memcpy(render_target, &px, sizeof(px));
+      render_target += 4;
+      bits >>= 8;
+    }
+  }
+}
+
+/*
+ * Portable equivalent of unpack_2bpp_overlay.S.
+ */
+__attribute__((section(".ramcode")))
+void unpack_2bpp_overlay_impl(uint32_t const *input_line,
+                              uint32_t const *lut,
+                              uint8_t *render_target,
+                              unsigned words_in_input,
+                              uint8_t const *background) {
+  uint32_t const *mask = lut + 256;
+
+  for (unsigned w = 0; w < words_in_input; ++w) {
+    uint32_t bits = *input_line++;
+    for (unsigned i = 0; i < 4; ++i) {
+      uint32_t px, bg;
+      std::memcpy(&bg, background, sizeof(bg));
+      px = (lut[bits & 0xFF] & ~mask[bits & 0xFF])
+         | (bg & mask[bits & 0xFF]);
+      std::memcpy(render_target, &px, sizeof(px));
+      render_target += 4;
+      background += 4;
+      bits >>= 8;
+    }
+  }
+}
+
+}  // namespace rast
+}  // namespace vga
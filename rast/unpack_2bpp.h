@@ -0,0 +1,39 @@
+#ifndef VGA_RAST_UNPACK_2BPP_H
+#define VGA_RAST_UNPACK_2BPP_H
+
+#include <cstdint>
+
+namespace vga {
+namespace rast {
+
+/*
+ * 2bpp unpackers.  Rather than a four-entry CLUT, these take a lookup table
+ * derived from one (see Bitmap_2): 256 words giving the four pixels encoded by
+ * each possible input byte, optionally followed by 256 words masking the
+ * pixels of color zero.
+ *
+ * 'words_in_input' must be nonzero: like most of the unpackers, the assembly
+ * versions test the count at the bottom of the loop, and so process one word
+ * when given zero.
+ */
+
+void unpack_2bpp_impl(std::uint32_t const *input_line,
+                      std::uint32_t const *lut,
+                      std::uint8_t *render_target,
+                      unsigned words_in_input);
+
+/*
+ * As unpack_2bpp_impl, but pixels of color zero are transparent, showing the
+ * corresponding pixels of 'background'.  Requires the mask half of the lookup
+ * table.  The background must be word-aligned.
+ */
+void unpack_2bpp_overlay_impl(std::uint32_t const *input_line,
+                              std::uint32_t const *lut,
+                              std::uint8_t *render_target,
+                              unsigned words_in_input,
+                              std::uint8_t const * background);
+
+}  // namespace rast
+}  // namespace vga
+
+#endif  // VGA_RAST_UNPACK_2BPP_H
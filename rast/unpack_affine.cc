@@ -0,0 +1,28 @@
+#include "vga/rast/unpack_affine.h"
+
+using std::uint8_t;
+using std::uint32_t;
+
+namespace vga {
+namespace rast {
+
+/*
+ * Portable equivalent of unpack_affine.S.
+ */
+__attribute__((section(".ramcode")))
+void unpack_affine_impl(uint8_t const *texture,
+                        AffineStep const &step,
+                        uint8_t *render_target,
+                        unsigned count) {
+  uint32_t u = step.u, v = step.v;
+
+  for (unsigned i = 0; i < count; ++i) {
+    uint32_t index = (u >> step.u_shift) | ((v >> step.v_shift) & ~step.x_mask);
+    render_target[i] = texture[index];
+    u += step.du;
+    v += step.dv;
+  }
+}
+
+}  // namespace rast
+}  // namespace vga
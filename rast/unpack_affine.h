@@ -0,0 +1,41 @@
+#ifndef VGA_RAST_UNPACK_AFFINE_H
+#define VGA_RAST_UNPACK_AFFINE_H
+
+#include <cstdint>
+
+namespace vga {
+namespace rast {
+
+/*
+ * Parameters for sampling one line of a texture whose sides are powers of
+ * two.  Coordinates are fixed point with the integer part in the most
+ * significant bits, so that they wrap around the texture for free.
+ *
+ * The texel at (u, v) is at index
+ *   (u >> u_shift) | ((v >> v_shift) & ~x_mask)
+ * where, for a texture of 2^w by 2^h texels, u_shift is 32-w, v_shift is
+ * 32-h-w, and x_mask is 2^w-1.
+ */
+struct AffineStep {
+  std::uint32_t u;
+  std::uint32_t v;
+  std::uint32_t du;
+  std::uint32_t dv;
+  unsigned u_shift;
+  unsigned v_shift;
+  std::uint32_t x_mask;
+};
+
+/*
+ * Samples 'count' texels along a line, which must be a nonzero multiple of 4.
+ * (The assembly version samples 4 texels for a count of zero.)
+ */
+void unpack_affine_impl(std::uint8_t const *texture,
+                        AffineStep const &step,
+                        std::uint8_t *render_target,
+                        unsigned count);
+
+}  // namespace rast
+}  // namespace vga
+
+#endif  // VGA_RAST_UNPACK_AFFINE_H
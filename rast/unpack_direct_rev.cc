@@ -0,0 +1,26 @@
+#include "vga/rast/unpack_direct_rev.h"
+
+namespace vga {
+namespace rast {
+
+/*
+ * Portable equivalent of unpack_direct_rev.S.
+ *
+ * Note that input_line is the off-the-end address of the input line, which is
+ * copied to the render target backwards.  Like the assembly version, this
+ * processes whole words, so bytes_in_input is rounded up to a multiple of four.
+ */
+__attribute__((section(".ramcode")))
+void unpack_direct_rev_impl(void const *input_line,
+                            unsigned char *render_target,
+                            unsigned bytes_in_input) {
+  auto end = static_cast<unsigned char const *>(input_line);
+  unsigned bytes = (bytes_in_input + 3) & ~3u;
+
+  for (unsigned i = 0; i < bytes; ++i) {
+    render_target[i] = end[-1 - int(i)];
+  }
+}
+
+}  // namespace rast
+}  // namespace vga
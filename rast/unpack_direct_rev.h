@@ -4,6 +4,12 @@
 namespace vga {
 namespace rast {
 
+/*
+ * Copies a line of pixels to 'render_target' in reverse order.  'input_line'
+ * is the word-aligned address just past the end of the input.  Whole words are
+ * copied, so 'bytes_in_input' is rounded up to a multiple of four; it must be
+ * nonzero, as the assembly version copies a word when given zero.
+ */
 void unpack_direct_rev_impl(void const *input_line,
                             unsigned char *render_target,
                             unsigned bytes_in_input);
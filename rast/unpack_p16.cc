@@ -0,0 +1,33 @@
+#include "vga/rast/unpack_p16.h"
+
+using std::uint8_t;
+using std::uint32_t;
+
+namespace vga {
+namespace rast {
+
+/*
+ * Portable equivalent of unpack_p16.S.
+ *
+ * Each input word holds 8 pixels, least significant nibble leftmost, each
+ * indexing the 16-entry palette.
+ */
+__attribute__((section(".ramcode")))
+void unpack_p16_impl(void const *input_line,
+                     unsigned char *render_target,
+                     unsigned words_in_input,
+                     uint8_t const *palette) {
+  auto input = static_cast<uint32_t const *>(input_line);
+
+  for (unsigned w = 0; w < words_in_input; ++w) {
+    uint32_t bits = *input++;
+    for (unsigned i = 0; i < 8; ++i) {
+      render_target[i] = palette[bits & 0xF];
+      bits >>= 4;
+    }
+    render_target += 8;
+  }
+}
+
+}  // namespace rast
+}  // namespace vga
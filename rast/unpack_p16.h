@@ -0,0 +1,22 @@
+#ifndef VGA_RAST_UNPACK_P16_H
+#define VGA_RAST_UNPACK_P16_H
+
+#include <cstdint>
+
+namespace vga {
+namespace rast {
+
+/*
+ * Translates 4bpp pixels through a 16-entry palette.  Each input word holds 8
+ * pixels, least significant nibble leftmost.  'words_in_input' must be
+ * nonzero, as the assembly version processes a word when given zero.
+ */
+void unpack_p16_impl(void const *input_line,
+                     unsigned char *render_target,
+                     unsigned words_in_input,
+                     std::uint8_t const * palette);
+
+}  // namespace rast
+}  // namespace vga
+
+#endif  // VGA_RAST_UNPACK_P16_H
@@ -0,0 +1,24 @@
+#include "vga/rast/unpack_p256.h"
+
+using std::uint8_t;
+
+namespace vga {
+namespace rast {
+
+/*
+ * Portable equivalent of unpack_p256.S: translates each input byte through a
+ * 256-entry palette.
+ */
+void unpack_p256_impl(void const *input_line,
+                      unsigned char *render_target,
+                      unsigned words_in_input,
+                      uint8_t const *palette) {
+  auto input = static_cast<uint8_t const *>(input_line);
+
+  for (unsigned i = 0; i < words_in_input * 4; ++i) {
+    render_target[i] = palette[input[i]];
+  }
+}
+
+}  // namespace rast
+}  // namespace vga
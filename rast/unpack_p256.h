@@ -6,6 +6,11 @@
 namespace vga {
 namespace rast {
 
+/*
+ * Translates 8bpp pixels through a 256-entry palette, a word (four pixels) at
+ * a time.  'words_in_input' must be nonzero, as the assembly version processes
+ * a word when given zero.
+ */
 void unpack_p256_impl(void const *input_line,
                       unsigned char *render_target,
                       unsigned words_in_input,
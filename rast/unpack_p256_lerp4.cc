@@ -0,0 +1,45 @@
+#include "vga/rast/unpack_p256_lerp4.h"
+
+#include "vga/rast/smmlar.h"
+
+using std::int32_t;
+using std::uint8_t;
+
+namespace vga {
+namespace rast {
+
+/*
+ * Portable equivalent of unpack_p256_lerp4.S.
+ *
+ * Each adjacent pair of input values produces four output pixels, linearly
+ * interpolating from the left value toward the right, using the same rounding
+ * as the assembly version.  An input line of n values thus produces 4 * (n-1)
+ * pixels.
+ */
+__attribute__((section(".ramcode")))
+void unpack_p256_lerp4_impl(void const *input_line,
+                            unsigned char *render_target,
+                            unsigned bytes_in_input,
+                            uint8_t const *palette0) {
+  auto input = static_cast<uint8_t const *>(input_line);
+
+  // Fixed-point ratios, at half their nominal values to stay positive.
+  static constexpr int32_t t1 = 0x20000000, t2 = 0x40000000, t3 = 0x60000000;
+
+  int32_t left = input[0];
+  for (unsigned i = 1; i < bytes_in_input; ++i) {
+    int32_t right = input[i];
+    int32_t delta = (right - left) * 2;
+
+    render_target[0] = palette0[left];
+    render_target[1] = palette0[smmlar(delta, t1, left)];
+    render_target[2] = palette0[smmlar(delta, t2, left)];
+    render_target[3] = palette0[smmlar(delta, t3, left)];
+    render_target += 4;
+
+    left = right;
+  }
+}
+
+}  // namespace rast
+}  // namespace vga
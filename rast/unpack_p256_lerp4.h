@@ -6,6 +6,13 @@
 namespace vga {
 namespace rast {
 
+/*
+ * Produces four pixels for each adjacent pair of input values, interpolating
+ * linearly from the left value toward the right, and translates them through
+ * 'palette0'.  'bytes_in_input' must be at least 2; the assembly version
+ * compares against the end of the input only after consuming a pair, so
+ * smaller counts run off the end.
+ */
 void unpack_p256_lerp4_impl(void const *input_line,
                             unsigned char *render_target,
                             unsigned bytes_in_input,
@@ -0,0 +1,51 @@
+#include "vga/rast/unpack_p256_lerp4_d4.h"
+
+#include "vga/rast/smmlar.h"
+
+using std::int32_t;
+using std::uint8_t;
+
+namespace vga {
+namespace rast {
+
+/*
+ * Portable equivalent of unpack_p256_lerp4_d4.S.
+ *
+ * Interpolates exactly like unpack_p256_lerp4_impl, but expands each
+ * interpolated value into four pixels alternating between the two palettes,
+ * for 16 output pixels per adjacent pair of input values.
+ */
+__attribute__((section(".ramcode")))
+void unpack_p256_lerp4_d4_impl(void const *input_line,
+                               unsigned char *render_target,
+                               unsigned bytes_in_input,
+                               uint8_t const *palette0,
+                               uint8_t const *palette1) {
+  auto input = static_cast<uint8_t const *>(input_line);
+
+  // Fixed-point ratios, at half their nominal values to stay positive.
+  static constexpr int32_t ratios[4] = {
+    0, 0x20000000, 0x40000000, 0x60000000,
+  };
+
+  int32_t left = input[0];
+  for (unsigned i = 1; i < bytes_in_input; ++i) {
+    int32_t right = input[i];
+    int32_t delta = (right - left) * 2;
+
+    for (auto ratio : ratios) {
+      int32_t v = smmlar(delta, ratio, left);
+      uint8_t p0 = palette0[v], p1 = palette1[v];
+      render_target[0] = p0;
+      render_target[1] = p1;
+      render_target[2] = p0;
+      render_target[3] = p1;
+      render_target += 4;
+    }
+
+    left = right;
+  }
+}
+
+}  // namespace rast
+}  // namespace vga
@@ -6,6 +6,11 @@
 namespace vga {
 namespace rast {
 
+/*
+ * As unpack_p256_lerp4_impl, but expands each interpolated value into four
+ * pixels alternating between 'palette0' and 'palette1', for 16 pixels per
+ * pair of input values.  'bytes_in_input' must likewise be at least 2.
+ */
 void unpack_p256_lerp4_d4_impl(void const *input_line,
                                unsigned char *render_target,
                                unsigned bytes_in_input,
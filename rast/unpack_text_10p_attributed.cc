@@ -0,0 +1,57 @@
+#include "vga/rast/unpack_text_10p_attributed.h"
+
+#include <cstdint>
+
+using std::uint8_t;
+using std::uint32_t;
+
+namespace vga {
+namespace rast {
+
+/*
+ * Portable equivalent of unpack_text_10p_attributed.S; see that file for the
+ * input and font formats.
+ *
+ * Each character produces ten pixels: eight from the font, least significant
+ * bit leftmost, followed by two pixels of background color.  Attributes set in
+ * both the character and attribute_mask modify this.
+ */
+__attribute__((section(".ramcode")))
+void unpack_text_10p_attributed_impl(void const *input_line,
+                                     unsigned char const *font,
+                                     unsigned char *render_target,
+                                     unsigned cols_in_input,
+                                     unsigned attribute_mask) {
+  auto text = static_cast<uint32_t const *>(input_line);
+
+  for (unsigned c = 0; c < cols_in_input; ++c) {
+    uint32_t cell = *text++;
+    uint8_t fore = uint8_t(cell >> 16);
+    uint8_t back = uint8_t(cell >> 8);
+    unsigned bits = font[uint8_t(cell)];
+
+    uint32_t effects = cell & attribute_mask;
+    if (effects & (1 << 24)) {
+      auto t = fore;
+      fore = back;
+      back = t;
+    }
+    if (effects & (1 << 26)) {
+      bits = 0;
+    } else if (effects & (1 << 25)) {
+      bits = 0xFF;
+      back = fore;
+    }
+
+    for (unsigned i = 0; i < 8; ++i) {
+      render_target[i] = (bits & 1) ? fore : back;
+      bits >>= 1;
+    }
+    render_target[8] = back;
+    render_target[9] = back;
+    render_target += 10;
+  }
+}
+
+}  // namespace rast
+}  // namespace vga
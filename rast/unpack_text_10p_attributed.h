@@ -4,10 +4,19 @@
 namespace vga {
 namespace rast {
 
+/*
+ * Draws one line of attributed text, ten pixels per character: eight from the
+ * font followed by two of background color.  See unpack_text_10p_attributed.S
+ * for the input and font formats.
+ *
+ * 'cols_in_input' must be nonzero; the assembly version counts down to zero,
+ * so given zero it runs off the end.
+ */
 void unpack_text_10p_attributed_impl(void const *input_line,
                                      unsigned char const *font,
                                      unsigned char *render_target,
-                                     unsigned cols_in_input);
+                                     unsigned cols_in_input,
+                                     unsigned attribute_mask);
 
 }  // namespace rast
 }  // namespace vga
@@ -0,0 +1,23 @@
+#ifndef VGA_RAST_UNPACK_TEXT_8P_ATTRIBUTED_H
+#define VGA_RAST_UNPACK_TEXT_8P_ATTRIBUTED_H
+
+namespace vga {
+namespace rast {
+
+/*
+ * Draws one line of attributed text, eight pixels per character with no
+ * gutter.  See unpack_text_10p_attributed.S for the input and font formats.
+ *
+ * 'cols_in_input' must be nonzero; the assembly version counts down to zero,
+ * so given zero it runs off the end.
+ */
+void unpack_text_8p_attributed_impl(void const *input_line,
+                                    unsigned char const *font,
+                                    unsigned char *render_target,
+                                    unsigned cols_in_input,
+                                    unsigned attribute_mask);
+
+}  // namespace rast
+}  // namespace vga
+
+#endif  // VGA_RAST_UNPACK_TEXT_8P_ATTRIBUTED_H
@@ -0,0 +1,25 @@
+#include "vga/rast/unpack_tile8.h"
+
+using std::uint8_t;
+
+namespace vga {
+namespace rast {
+
+/*
+ * Portable equivalent of unpack_tile8.S.
+ */
+__attribute__((section(".ramcode")))
+void unpack_tile8_impl(uint8_t const *map,
+                       uint8_t const *patterns,
+                       uint8_t *render_target,
+                       unsigned tile_count) {
+  for (unsigned t = 0; t < tile_count; ++t) {
+    auto row = patterns + map[t] * 64;
+    for (unsigned i = 0; i < 8; ++i) {
+      *render_target++ = row[i];
+    }
+  }
+}
+
+}  // namespace rast
+}  // namespace vga
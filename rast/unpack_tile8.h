@@ -0,0 +1,23 @@
+#ifndef VGA_RAST_UNPACK_TILE8_H
+#define VGA_RAST_UNPACK_TILE8_H
+
+#include <cstdint>
+
+namespace vga {
+namespace rast {
+
+/*
+ * Draws one row of pixels from each of a run of 8x8 tiles.  'map' gives the
+ * tile numbers; 'patterns' points to the row being drawn within tile 0 of a
+ * table of word-aligned, 64-byte tile patterns.  The output need not be
+ * aligned.  'tile_count' may be zero.
+ */
+void unpack_tile8_impl(std::uint8_t const *map,
+                       std::uint8_t const *patterns,
+                       std::uint8_t *render_target,
+                       unsigned tile_count);
+
+}  // namespace rast
+}  // namespace vga
+
+#endif  // VGA_RAST_UNPACK_TILE8_H
@@ -50,6 +50,14 @@ public:
                                unsigned line_number,
                                Pixel *raster_target) = 0;
 
+  /*
+   * How many pixels a rasterizer may write outside either end of the line it
+   * produces, e.g. to draw whole tiles at a fine scroll position.  The
+   * driver's working buffers are padded by this much, and so must be any
+   * buffer a Rasterizer hands to another.
+   */
+  static constexpr unsigned max_overrun = 16;
+
 protected:
   ~Rasterizer() = default;
 };
@@ -0,0 +1,229 @@
+#include "vga/sim.h"
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "vga/backend.h"
+#include "vga/rasterizer.h"
+#include "vga/timing.h"
+#include "vga/vga.h"
+
+using std::uint32_t;
+using std::uint64_t;
+
+namespace vga {
+
+/*******************************************************************************
+ * Simulator state.
+ */
+
+// A copy of the current Timing.
+static Timing timing;
+
+// Whether the simulated line clock is running.
+static bool running;
+
+// The line being simulated.  This tracks the driver's current_line.
+static unsigned line;
+
+// Set by pend_hblank_work, consumed at the start of the next line.
+static bool hblank_pended;
+
+// Output enables.
+static bool video_enabled;
+
+// Scanout configuration set by prepare_scanout and used at SAV.
+static Rasterizer::Pixel const *scan_pixels;
+static Rasterizer::RasterInfo scan_shape;
+
+// The frame being scanned out, and the last complete frame.
+static std::vector<Pixel> frames[2];
+static unsigned drawing_frame;
+
+// Accounting, one record per line including blanking.
+static std::vector<sim::LineRecord> records;
+
+// When the current Timing was configured, as the origin for cycle_count.
+static std::chrono::steady_clock::time_point timing_start;
+
+
+/*
+ * Returns the CPU clock rate the current Timing would produce on hardware.
+ */
+static uint64_t cpu_hz() {
+  auto const &c = timing.clock_config;
+  return uint64_t(c.crystal_hz) / c.crystal_divisor
+       * c.vco_multiplier / c.general_divisor;
+}
+
+
+/*******************************************************************************
+ * Public API that is purely a matter of hardware.
+ */
+
+void sync_off() {}
+void sync_on() {}
+
+void video_off() {
+  video_enabled = false;
+}
+
+void video_on() {
+  video_enabled = true;
+}
+
+
+/*******************************************************************************
+ * Backend implementation.
+ */
+
+namespace backend {
+
+void init() {
+  running = false;
+  video_enabled = false;
+}
+
+void stop_timing() {
+  running = false;
+}
+
+void configure_timing(Timing const &t) {
+  timing = t;
+  timing_start = std::chrono::steady_clock::now();
+  line = 0;
+  hblank_pended = false;
+  scan_pixels = nullptr;
+  scan_shape = { 0, 0, t.cycles_per_pixel, 0 };
+
+  auto frame_pixels = unsigned(t.video_pixels)
+                    * (t.video_end_line - t.video_start_line);
+  for (auto &f : frames) f.assign(frame_pixels, 0);
+  drawing_frame = 0;
+
+  records.assign(t.video_end_line, sim::LineRecord{false, 0});
+}
+
+void start_timing() {
+  running = true;
+}
+
+void prepare_scanout(Rasterizer::Pixel const *pixels,
+                     Rasterizer::RasterInfo const &shape) {
+  scan_pixels = pixels;
+  scan_shape = shape;
+}
+
+void start_scanout() {
+  records[line].displayed = true;
+
+  unsigned row = line - timing.video_start_line;
+  if (row >= sim::get_frame_height()) return;
+
+  Pixel *out = &frames[drawing_frame][row * timing.video_pixels];
+  if (!video_enabled || !scan_pixels) return;
+
+  // The hardware can't go faster than 4 cycles per pixel; see prepare_scanout
+  // in the STM32F4 backend.
+  unsigned cycles_per_pixel = scan_shape.cycles_per_pixel > 4
+                            ? scan_shape.cycles_per_pixel : 4;
+
+  // Sample the line at the mode's native pixel clock.
+  for (unsigned x = 0; x < timing.video_pixels; ++x) {
+    int rel = int(x) - scan_shape.offset;
+    if (rel < 0) continue;
+    unsigned i = unsigned(rel) * timing.cycles_per_pixel / cycles_per_pixel;
+    if (i < scan_shape.length) out[x] = scan_pixels[i];
+  }
+}
+
+void end_scanout() {}
+
+void pend_hblank_work() {
+  hblank_pended = true;
+}
+
+void toggle_vsync() {}
+
+std::uint32_t cycle_count() {
+  // Scale host time to the simulated CPU's clock rate.
+  std::chrono::duration<double> t =
+    std::chrono::steady_clock::now() - timing_start;
+  return uint32_t(uint64_t(t.count() * cpu_hz()));
+}
+
+void idle() {
+  sim::step_line();
+}
+
+}  // namespace backend
+
+
+/*******************************************************************************
+ * Simulator API.
+ */
+
+namespace sim {
+
+void step_line() {
+  if (!running) return;
+
+  auto &record = records[line];
+  record.displayed = false;
+  record.hblank_ns = 0;
+
+  // Hblank work pended by the previous line's EAV runs at the start of this
+  // line, before SAV.
+  if (hblank_pended) {
+    hblank_pended = false;
+    auto start = std::chrono::steady_clock::now();
+    hblank_work();
+    auto end = std::chrono::steady_clock::now();
+    record.hblank_ns = uint32_t(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end - start)
+        .count());
+  }
+
+  start_of_active_video();
+  end_of_active_video();
+
+  // Mirror the driver's line counter.
+  if (++line == timing.video_end_line) {
+    line = 0;
+    drawing_frame = !drawing_frame;
+    for (auto &p : frames[drawing_frame]) p = 0;
+  }
+}
+
+void step_frame() {
+  if (!running) return;
+
+  do {
+    step_line();
+  } while (line != 0);
+}
+
+Pixel const *get_frame() {
+  return frames[!drawing_frame].data();
+}
+
+unsigned get_frame_width() {
+  return timing.video_pixels;
+}
+
+unsigned get_frame_height() {
+  return timing.video_end_line - timing.video_start_line;
+}
+
+LineRecord const &get_line_record(unsigned l) {
+  return records[l];
+}
+
+uint32_t get_line_budget_ns() {
+  uint64_t cycles = uint64_t(timing.line_pixels) * timing.cycles_per_pixel;
+  return uint32_t(cycles * 1000000000 / cpu_hz());
+}
+
+}  // namespace sim
+}  // namespace vga
@@ -0,0 +1,87 @@
+#ifndef VGA_SIM_H
+#define VGA_SIM_H
+
+#include <cstdint>
+
+#include "vga/vga.h"
+
+namespace vga {
+namespace sim {
+
+/*
+ * Host-side simulation of the video hardware.
+ *
+ * When the driver is built for the host (the vga_sim library), there are no
+ * timers or DMA to drive it.  Instead, a simulated line clock delivers the same
+ * per-line events as the real hardware -- start of active video, end of active
+ * video, and hblank work -- and scanout copies pixels into an in-memory frame
+ * instead of onto GPIO pins.
+ *
+ * The usual driver API (init, configure_band_list, configure_timing, ...) works
+ * unchanged.  The clock advances whenever the application would idle waiting
+ * for the driver, e.g. in sync_to_vblank, or explicitly using the functions
+ * below.  This means the same application code can drive the simulation.
+ *
+ * Events are delivered synchronously and hblank work always runs to completion
+ * before the next line begins, so the simulation shows what the hardware
+ * *would* display if every rasterizer met its deadline.  Use the per-line
+ * records to find out whether they would have.
+ *
+ * The driver's own deadline monitoring (vga::get_band_stats) works too, using
+ * host time scaled to the simulated CPU clock.  Host and hardware speeds
+ * differ, so overrun counts are only indicative.
+ */
+
+/*
+ * Per-line accounting, recorded each time the line is simulated.
+ */
+struct LineRecord {
+  // Whether pixels were scanned out on this line.
+  bool displayed;
+  // Wall-clock time spent in hblank work (scanout preparation, the
+  // application's hblank hook, and rasterization) on this line.
+  std::uint32_t hblank_ns;
+};
+
+/*
+ * Advances the simulated line clock by one line.
+ */
+void step_line();
+
+/*
+ * Advances the simulated line clock to the start of the next frame, i.e.
+ * until line zero begins.
+ */
+void step_frame();
+
+/*
+ * Returns the pixels scanned out during the most recent frame, as rows of
+ * get_frame_width() pixels, top to bottom.  Rows that weren't scanned out,
+ * and pixels outside the range produced by the rasterizer, are zero.
+ *
+ * Pixels are sampled at the mode's native pixel clock, so a rasterizer that
+ * requests e.g. double-width pixels shows up as pairs of identical pixels.
+ */
+Pixel const *get_frame();
+unsigned get_frame_width();
+unsigned get_frame_height();
+
+/*
+ * Returns the accounting record for the given line, counted from the top of
+ * the frame (including vertical blanking), as of the last time it was
+ * simulated.
+ */
+LineRecord const &get_line_record(unsigned line);
+
+/*
+ * Returns the duration of one line on real hardware in the current mode, in
+ * nanoseconds, for comparison against LineRecord::hblank_ns.  (Host and
+ * hardware speeds differ wildly, so this is useful for relative comparisons,
+ * not as a pass/fail criterion.)
+ */
+std::uint32_t get_line_budget_ns();
+
+}  // namespace sim
+}  // namespace vga
+
+#endif  // VGA_SIM_H
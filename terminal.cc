@@ -0,0 +1,536 @@
+#include "vga/terminal.h"
+
+#include <cstring>
+
+#include "etl/assert.h"
+#include "etl/prediction.h"
+
+#include "vga/copy_words.h"
+
+using std::uint8_t;
+using std::uint32_t;
+
+namespace vga {
+
+static constexpr uint8_t default_fore = 7, default_back = 0;
+
+// Parameters larger than this are clamped while parsing, so they can't
+// overflow.
+static constexpr unsigned max_param_value = 9999;
+
+static constexpr Rasterizer::Pixel rgb(unsigned r, unsigned g, unsigned b) {
+  return Rasterizer::Pixel(r << 4 | g << 2 | b);
+}
+
+static constexpr bool is_printable(uint8_t c) {
+  return c >= 0x20 && c != 0x7F;
+}
+
+
+/*******************************************************************************
+ * Construction and configuration.
+ */
+
+template <typename T>
+Terminal<T>::Terminal(T &text)
+  : _text(text),
+    _cols(text.get_col_count()),
+    _rows(text.get_full_row_count()) {
+  // ANSI color numbers are a bit per channel: red, green, blue.
+  for (unsigned i = 0; i < 8; ++i) {
+    _colors[i] = rgb(i & 1 ? 2 : 0, i & 2 ? 2 : 0, i & 4 ? 2 : 0);
+    _colors[i + 8] = rgb(i & 1 ? 3 : 0, i & 2 ? 3 : 0, i & 4 ? 3 : 0);
+  }
+  _colors[8] = rgb(1, 1, 1);  // Bright black is dark gray.
+
+  reset();
+}
+
+template <typename T>
+void Terminal<T>::reset() {
+  _state = State::ground;
+  _private = false;
+  _param_count = 0;
+
+  _autowrap = true;
+  _newline_mode = true;
+  _top = 0;
+  _bottom = _rows;
+
+  _fore = default_fore;
+  _back = default_back;
+  _bold = false;
+  _attributes = 0;
+  update_pen();
+
+  _col = _row = 0;
+  _wrap_pending = false;
+  save_cursor();
+
+  // Include any row cut off below the last, which the Terminal doesn't use but
+  // is still shown.
+  erase_rows(0, _text.get_row_count());
+}
+
+template <typename T>
+void Terminal<T>::set_color(unsigned index, Pixel p) {
+  ETL_ASSERT(index < 16);
+  _colors[index] = p;
+  update_pen();
+}
+
+template <typename T>
+void Terminal<T>::update_pen() {
+  unsigned fore = _fore;
+  if (_bold && fore < 8) fore += 8;
+
+  _pen = uint32_t(_attributes) << 24
+       | uint32_t(_colors[fore]) << 16
+       | uint32_t(_colors[_back]) << 8;
+  _blank = uint32_t(_colors[_back]) << 8 | ' ';
+}
+
+
+/*******************************************************************************
+ * Input.
+ */
+
+template <typename T>
+void Terminal<T>::write(char const *string) {
+  write(string, unsigned(std::strlen(string)));
+}
+
+template <typename T>
+void Terminal<T>::write(char const *data, unsigned length) {
+  unsigned i = 0;
+  while (i < length) {
+    auto c = uint8_t(data[i]);
+
+    if (_state != State::ground || !is_printable(c)) {
+      switch (_state) {
+        case State::ground:      control(c); break;
+        case State::escape:      escape(c); break;
+        case State::escape_skip: _state = State::ground; break;
+        case State::csi:         csi(c); break;
+      }
+      ++i;
+      continue;
+    }
+
+    // Printable characters.  These are the bulk of most streams, so write as
+    // many as fit on this line in one go.
+    if (_wrap_pending) {
+      _col = 0;
+      line_feed();
+    }
+
+    auto cells = _text.get_row_cells(_row) + _col;
+    auto pen = _pen;
+    unsigned room = _cols - _col;
+    unsigned n = 0;
+    while (n < room && i < length) {
+      c = uint8_t(data[i]);
+      if (ETL_UNLIKELY(!is_printable(c))) break;
+      cells[n++] = pen | c;
+      ++i;
+    }
+
+    _col += n;
+    if (_col == _cols) {
+      // Stay in the last column until there's something to wrap.  Without
+      // autowrap, further characters overwrite it.
+      _col = _cols - 1;
+      _wrap_pending = _autowrap;
+    }
+  }
+}
+
+template <typename T>
+void Terminal<T>::control(uint8_t c) {
+  switch (c) {
+    case '\b':
+      if (_col) --_col;
+      _wrap_pending = false;
+      break;
+
+    case '\t':
+      _col = (_col / 8 + 1) * 8;
+      if (_col >= _cols) _col = _cols - 1;
+      _wrap_pending = false;
+      break;
+
+    case '\n':
+    case '\v':
+    case '\f':
+      if (_newline_mode) _col = 0;
+      line_feed();
+      break;
+
+    case '\r':
+      _col = 0;
+      _wrap_pending = false;
+      break;
+
+    case 0x18:  // CAN and SUB abandon any sequence in progress.
+    case 0x1A:
+      _state = State::ground;
+      break;
+
+    case 0x1B:
+      _state = State::escape;
+      break;
+
+    default:  // Including BEL.
+      break;
+  }
+}
+
+template <typename T>
+void Terminal<T>::escape(uint8_t c) {
+  _state = State::ground;
+
+  switch (c) {
+    case '[':
+      _state = State::csi;
+      _private = false;
+      _param_count = 0;
+      break;
+
+    case '7': save_cursor(); break;
+    case '8': restore_cursor(); break;
+    case 'D': line_feed(); break;
+    case 'E': _col = 0; line_feed(); break;
+    case 'M': reverse_index(); break;
+    case 'c': reset(); break;
+
+    case '(':  // Character set and line size selection take another byte.
+    case ')':
+    case '#':
+      _state = State::escape_skip;
+      break;
+
+    default:
+      if (c < 0x20) control(c);
+      break;
+  }
+}
+
+template <typename T>
+unsigned Terminal<T>::param(unsigned index, unsigned fallback) const {
+  if (index >= _param_count || index >= max_params) return fallback;
+  // As on the VT100, zero means the default.
+  return _params[index] ? _params[index] : fallback;
+}
+
+template <typename T>
+void Terminal<T>::csi(uint8_t c) {
+  if (c < 0x20) {
+    control(c);
+    return;
+  }
+
+  if (c >= '0' && c <= '9') {
+    if (_param_count == 0) _params[_param_count++] = 0;
+    if (_param_count <= max_params) {
+      auto &p = _params[_param_count - 1];
+      p = p * 10 + unsigned(c - '0');
+      if (p > max_param_value) p = max_param_value;
+    }
+    return;
+  }
+
+  if (c == ';') {
+    if (_param_count == 0) _params[_param_count++] = 0;
+    if (_param_count < max_params) _params[_param_count] = 0;
+    ++_param_count;
+    return;
+  }
+
+  if (c >= '<' && c <= '?') {
+    _private = true;
+    return;
+  }
+
+  // Intermediate bytes are ignored.
+  if (c < 0x40) return;
+
+  _state = State::ground;
+
+  if (_private) {
+    if (c == 'h' || c == 'l') {
+      for (unsigned i = 0; i < _param_count && i < max_params; ++i) {
+        if (_params[i] == 7) _autowrap = c == 'h';
+      }
+    }
+    return;
+  }
+
+  unsigned n = param(0, 1);
+
+  // Vertical cursor motion stops at the scroll region's margins, if it
+  // starts inside them.
+  unsigned up_limit = _row >= _top ? _top : 0;
+  unsigned up = _row >= up_limit + n ? _row - n : up_limit;
+  unsigned down_limit = _row < _bottom ? _bottom - 1 : _rows - 1;
+  unsigned down = _row + n < down_limit ? _row + n : down_limit;
+
+  switch (c) {
+    case 'A': move_to(_col, up); break;
+    case 'B': move_to(_col, down); break;
+    case 'C': move_to(_col + n, _row); break;
+    case 'D': move_to(_col > n ? _col - n : 0, _row); break;
+    case 'E': move_to(0, down); break;
+    case 'F': move_to(0, up); break;
+    case 'G': move_to(n - 1, _row); break;
+    case 'd': move_to(_col, n - 1); break;
+
+    case 'H':
+    case 'f':
+      move_to(param(1, 1) - 1, n - 1);
+      break;
+
+    case 'J':
+      switch (param(0, 0)) {
+        case 0:
+          erase(_row, _col, _cols);
+          erase_rows(_row + 1, _rows);
+          break;
+        case 1:
+          erase_rows(0, _row);
+          erase(_row, 0, _col + 1);
+          break;
+        default:
+          erase_rows(0, _rows);
+          break;
+      }
+      break;
+
+    case 'K':
+      switch (param(0, 0)) {
+        case 0: erase(_row, _col, _cols); break;
+        case 1: erase(_row, 0, _col + 1); break;
+        default: erase(_row, 0, _cols); break;
+      }
+      break;
+
+    case 'L':
+      if (_row >= _top && _row < _bottom) {
+        scroll_down(_row, _bottom, n);
+        move_to(0, _row);
+      }
+      break;
+
+    case 'M':
+      if (_row >= _top && _row < _bottom) {
+        scroll_up(_row, _bottom, n);
+        move_to(0, _row);
+      }
+      break;
+
+    case 'S': scroll_up(_top, _bottom, n); break;
+    case 'T': scroll_down(_top, _bottom, n); break;
+
+    case 'm': select_graphic_rendition(); break;
+
+    case 'r': {
+      unsigned top = n - 1;
+      unsigned bottom = param(1, _rows);
+      if (top + 1 < bottom && bottom <= _rows) {
+        _top = top;
+        _bottom = bottom;
+        move_to(0, 0);
+      }
+      break;
+    }
+
+    case 's': save_cursor(); break;
+    case 'u': restore_cursor(); break;
+
+    case 'h':
+    case 'l':
+      for (unsigned i = 0; i < _param_count && i < max_params; ++i) {
+        if (_params[i] == 20) _newline_mode = c == 'h';
+      }
+      break;
+
+    default:
+      break;
+  }
+}
+
+template <typename T>
+void Terminal<T>::select_graphic_rendition() {
+  if (_param_count == 0) _params[_param_count++] = 0;
+
+  unsigned count = _param_count < max_params ? _param_count : max_params;
+  for (unsigned i = 0; i < count; ++i) {
+    unsigned p = _params[i];
+    if (p == 0) {
+      _fore = default_fore;
+      _back = default_back;
+      _bold = false;
+      _attributes = 0;
+    } else if (p == 1) {
+      _bold = true;
+    } else if (p == 22) {
+      _bold = false;
+    } else if (p == 4) {
+      _attributes |= T::underline;
+    } else if (p == 24) {
+      _attributes &= ~T::underline;
+    } else if (p == 5) {
+      _attributes |= T::blink;
+    } else if (p == 25) {
+      _attributes &= ~T::blink;
+    } else if (p == 7) {
+      _attributes |= T::inverse;
+    } else if (p == 27) {
+      _attributes &= ~T::inverse;
+    } else if (p >= 30 && p <= 37) {
+      _fore = uint8_t(p - 30);
+    } else if (p == 39) {
+      _fore = default_fore;
+    } else if (p >= 40 && p <= 47) {
+      _back = uint8_t(p - 40);
+    } else if (p == 49) {
+      _back = default_back;
+    } else if (p >= 90 && p <= 97) {
+      _fore = uint8_t(p - 90 + 8);
+    } else if (p >= 100 && p <= 107) {
+      _back = uint8_t(p - 100 + 8);
+    } else if (p == 38 || p == 48) {
+      // Extended colors: 5;n picks from a 256-color palette, of which we have
+      // the first 16; 2;r;g;b isn't supported.  Either way, skip the
+      // arguments so they aren't taken for attributes.
+      if (i + 2 < count && _params[i + 1] == 5) {
+        if (_params[i + 2] < 16) {
+          (p == 38 ? _fore : _back) = uint8_t(_params[i + 2]);
+        }
+        i += 2;
+      } else if (i + 1 < count && _params[i + 1] == 2) {
+        i += 4;
+      } else {
+        break;
+      }
+    }
+  }
+
+  update_pen();
+}
+
+
+/*******************************************************************************
+ * Cursor motion.
+ */
+
+template <typename T>
+void Terminal<T>::move_to(unsigned col, unsigned row) {
+  _col = col < _cols ? col : _cols - 1;
+  _row = row < _rows ? row : _rows - 1;
+  _wrap_pending = false;
+}
+
+template <typename T>
+void Terminal<T>::line_feed() {
+  _wrap_pending = false;
+  if (_row + 1 == _bottom) {
+    scroll_up(_top, _bottom, 1);
+  } else if (_row + 1 < _rows) {
+    ++_row;
+  }
+}
+
+template <typename T>
+void Terminal<T>::reverse_index() {
+  _wrap_pending = false;
+  if (_row == _top) {
+    scroll_down(_top, _bottom, 1);
+  } else if (_row) {
+    --_row;
+  }
+}
+
+template <typename T>
+void Terminal<T>::save_cursor() {
+  _saved_col = _col;
+  _saved_row = _row;
+  _saved_fore = _fore;
+  _saved_back = _back;
+  _saved_bold = _bold;
+  _saved_attributes = _attributes;
+}
+
+template <typename T>
+void Terminal<T>::restore_cursor() {
+  _fore = _saved_fore;
+  _back = _saved_back;
+  _bold = _saved_bold;
+  _attributes = _saved_attributes;
+  update_pen();
+  move_to(_saved_col, _saved_row);
+}
+
+
+/*******************************************************************************
+ * Framebuffer operations.
+ */
+
+template <typename T>
+void Terminal<T>::erase(unsigned row, unsigned first_col, unsigned end_col) {
+  auto cells = _text.get_row_cells(row);
+  auto blank = _blank;
+  for (unsigned i = first_col; i < end_col; ++i) {
+    cells[i] = blank;
+  }
+}
+
+template <typename T>
+void Terminal<T>::erase_rows(unsigned first_row, unsigned end_row) {
+  for (unsigned row = first_row; row < end_row; ++row) {
+    erase(row, 0, _cols);
+  }
+}
+
+template <typename T>
+void Terminal<T>::scroll_up(unsigned top, unsigned bottom, unsigned count) {
+  if (count > bottom - top) count = bottom - top;
+
+  if (top == 0 && bottom == _rows && count == 1
+      && !_text.is_scroll_pending()) {
+    // The common case: move the Text's ring rather than the text.  This
+    // works for one row per frame.  The row it erases is the one below the
+    // Terminal -- hidden, or cut off and already blank -- but a second would be
+    // the top row of the frame still being shown.
+    _text.scroll(1);
+    // A cut-off row now shows the ring's hidden row, which holds old text.
+    erase_rows(_rows, _text.get_row_count());
+  } else {
+    for (unsigned row = top; row + count < bottom; ++row) {
+      copy_words(_text.get_row_cells(row + count),
+                 _text.get_row_cells(row),
+                 _cols);
+    }
+  }
+
+  erase_rows(bottom - count, bottom);
+}
+
+template <typename T>
+void Terminal<T>::scroll_down(unsigned top, unsigned bottom, unsigned count) {
+  if (count > bottom - top) count = bottom - top;
+
+  for (unsigned row = bottom; row-- > top + count;) {
+    copy_words(_text.get_row_cells(row - count),
+               _text.get_row_cells(row),
+               _cols);
+  }
+
+  erase_rows(top, top + count);
+}
+
+template class Terminal<rast::Text_10x16>;
+template class Terminal<rast::Text_8x16>;
+template class Terminal<rast::Text_8x8>;
+template class Terminal<rast::Text_6x12>;
+
+}  // namespace vga
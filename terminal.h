@@ -0,0 +1,153 @@
+#ifndef VGA_TERMINAL_H
+#define VGA_TERMINAL_H
+
+#include <cstdint>
+
+#include "vga/rasterizer.h"
+#include "vga/rast/text.h"
+
+namespace vga {
+
+/*
+ * Interprets a stream of characters and VT100/ANSI escape sequences, drawing
+ * them into the framebuffer of a Text rasterizer -- e.g. for showing logs
+ * meant for a serial terminal.
+ *
+ * Supported:
+ *  - Controls: BS, HT (stops every 8 columns), LF/VT/FF, CR.
+ *  - ESC 7 / ESC 8 (save/restore cursor), ESC D (index), ESC E (next line),
+ *    ESC M (reverse index), ESC c (reset).
+ *  - CSI A B C D E F G H d f (cursor movement), J K (erase in display/line),
+ *    L M (insert/delete lines), S T (scroll), m (SGR), r (scroll region),
+ *    s u (save/restore cursor), h l for modes 20 (newline) and ?7 (autowrap).
+ *  - SGR 0, 1 and 22 (bold, shown as bright colors), 4 and 24, 5 and 25,
+ *    7 and 27 (using the Text attributes), 30-37, 39, 40-47, 49, 90-97, and
+ *    100-107.
+ * Anything else is parsed and ignored.  There's no visible cursor.
+ *
+ * Printable characters are written straight into the framebuffer in runs,
+ * one cell word per character, rather than through put_char.  Erasing uses
+ * the current background color.  Scrolling the whole display by one row moves
+ * the Text's ring origin, once per frame; other scrolling copies rows.
+ *
+ * Bytes from 0x80 up are drawn from the font like any other character.
+ *
+ * Terminal is a template on the Text type; terminal.cc instantiates it for
+ * each Text alias.
+ */
+template <typename TextRasterizer>
+class Terminal {
+public:
+  using Pixel = Rasterizer::Pixel;
+
+  /*
+   * Creates a Terminal drawing into 'text', which it resets and clears.  The
+   * Terminal assumes it's the only thing writing to the Text, and uses only
+   * the rows it shows in full (see Text::get_full_row_count), keeping any row
+   * cut off at the bottom blank.
+   */
+  explicit Terminal(TextRasterizer &text);
+
+  /*
+   * Interprets 'length' bytes.  Escape sequences may be split across calls.
+   */
+  void write(char const *data, unsigned length);
+
+  /*
+   * Interprets a NUL-terminated string.
+   */
+  void write(char const *string);
+
+  /*
+   * Restores the power-on state -- default colors and modes, no scroll
+   * region, cursor at top left -- and clears the display.
+   */
+  void reset();
+
+  unsigned get_cursor_col() const { return _col; }
+  unsigned get_cursor_row() const { return _row; }
+
+  /*
+   * Sets the pixel used for one of the 16 ANSI colors: 0-7 are black, red,
+   * green, yellow, blue, magenta, cyan, and white, and 8-15 their bright
+   * versions.  Affects characters written afterwards.
+   */
+  void set_color(unsigned index, Pixel);
+
+  /*
+   * In newline mode (the default, unlike a real VT100) LF, VT, and FF also
+   * return the cursor to the first column, as logs usually expect.
+   */
+  void set_newline_mode(bool on) { _newline_mode = on; }
+
+private:
+  static constexpr unsigned max_params = 8;
+
+  enum class State : std::uint8_t {
+    ground,
+    escape,
+    escape_skip,   // Swallowing the byte after e.g. ESC ( .
+    csi,
+  };
+
+  TextRasterizer &_text;
+  unsigned _cols;
+  unsigned _rows;
+
+  State _state;
+  bool _private;
+  unsigned _param_count;
+  unsigned _params[max_params];
+
+  unsigned _col;
+  unsigned _row;
+  bool _wrap_pending;     // Printed in the last column; wrap before the next.
+  bool _autowrap;
+  bool _newline_mode;
+  unsigned _top;          // Scroll region, as [_top, _bottom).
+  unsigned _bottom;
+
+  // SGR state, and the cells it produces.
+  std::uint8_t _fore;     // Color index.
+  std::uint8_t _back;
+  bool _bold;
+  std::uint8_t _attributes;
+  std::uint32_t _pen;     // Cell word, less the character.
+  std::uint32_t _blank;   // Cell word for erased cells.
+
+  unsigned _saved_col;
+  unsigned _saved_row;
+  std::uint8_t _saved_fore;
+  std::uint8_t _saved_back;
+  bool _saved_bold;
+  std::uint8_t _saved_attributes;
+
+  Pixel _colors[16];
+
+  void control(std::uint8_t);
+  void escape(std::uint8_t);
+  void csi(std::uint8_t);
+  void select_graphic_rendition();
+  unsigned param(unsigned index, unsigned fallback) const;
+
+  void update_pen();
+  void line_feed();
+  void reverse_index();
+  void move_to(unsigned col, unsigned row);
+  void save_cursor();
+  void restore_cursor();
+
+  void erase(unsigned row, unsigned first_col, unsigned end_col);
+  void erase_rows(unsigned first_row, unsigned end_row);
+  void scroll_up(unsigned top, unsigned bottom, unsigned count);
+  void scroll_down(unsigned top, unsigned bottom, unsigned count);
+};
+
+extern template class Terminal<rast::Text_10x16>;
+extern template class Terminal<rast::Text_8x16>;
+extern template class Terminal<rast::Text_8x8>;
+extern template class Terminal<rast::Text_6x12>;
+
+}  // namespace vga
+
+#endif  // VGA_TERMINAL_H
@@ -0,0 +1,514 @@
+/*
+ * Differential test and benchmark for the rasterization kernels.
+ *
+ * Each kernel the library was built with is run against its portable C++
+ * version -- compiled into this file, in namespace 'portable' -- on random
+ * inputs and random initial output, within the counts its header allows, and
+ * the outputs are compared byte for byte.  Each is then timed on a line of
+ * about 800 pixels.
+ *
+ * Linked against 'vga' on the target, this checks the assembly kernels against
+ * the C++ ones -- which the simulator relies upon being bit-exact -- and
+ * compares their speed.  That needs the application's startup code, and a
+ * stdout such as semihosting.  Linked against 'vga_sim', as in BUILD, both
+ * sides are the same C++, so it checks only the harness, and measures the
+ * portable kernels on the build machine in simulated cycles (see profile.h).
+ *
+ * The assembly has not yet been checked this way on hardware.  It has been
+ * checked against the portable kernels under an instruction-level emulator,
+ * over the ranges used here, with no differences; see the history of this
+ * file for how, and for the results.
+ *
+ * Exits nonzero on failure.
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include "vga/backend.h"
+#include "vga/copy_words.h"
+#include "vga/timing.h"
+#include "vga/vga.h"
+#include "vga/rast/fill_pixels.h"
+#include "vga/rast/merge_keyed.h"
+#include "vga/rast/unpack_1bpp.h"
+#include "vga/rast/unpack_2bpp.h"
+#include "vga/rast/unpack_affine.h"
+#include "vga/rast/unpack_direct_rev.h"
+#include "vga/rast/unpack_p16.h"
+#include "vga/rast/unpack_p256.h"
+#include "vga/rast/unpack_p256_lerp4.h"
+#include "vga/rast/unpack_p256_lerp4_d4.h"
+#include "vga/rast/unpack_text_10p_attributed.h"
+#include "vga/rast/unpack_text_6p_attributed.h"
+#include "vga/rast/unpack_text_8p_attributed.h"
+#include "vga/rast/unpack_tile8.h"
+
+/*
+ * The portable kernels, under another name.  Their headers, and the standard
+ * headers they use, were included above, so the includes within are no-ops.
+ */
+namespace portable {
+
+namespace vga {
+namespace rast {
+using ::vga::rast::AffineStep;
+}  // namespace rast
+}  // namespace vga
+
+#include "vga/copy_words.cc"
+#include "vga/rast/fill_pixels.cc"
+#include "vga/rast/merge_keyed.cc"
+#include "vga/rast/unpack_1bpp.cc"
+#include "vga/rast/unpack_2bpp.cc"
+#include "vga/rast/unpack_affine.cc"
+#include "vga/rast/unpack_direct_rev.cc"
+#include "vga/rast/unpack_p16.cc"
+#include "vga/rast/unpack_p256.cc"
+#include "vga/rast/unpack_p256_lerp4.cc"
+#include "vga/rast/unpack_p256_lerp4_d4.cc"
+#include "vga/rast/unpack_text_10p_attributed.cc"
+#include "vga/rast/unpack_text_6p_attributed.cc"
+#include "vga/rast/unpack_text_8p_attributed.cc"
+#include "vga/rast/unpack_tile8.cc"
+
+}  // namespace portable
+
+using std::uint8_t;
+using std::uint32_t;
+using Word = etl::armv7m::Word;
+
+namespace rast = vga::rast;
+namespace ref = portable::vga::rast;
+
+namespace {
+
+constexpr unsigned trials = 250;
+constexpr unsigned benchmark_reps = 200;
+
+alignas(4) uint8_t input[8192];
+alignas(4) uint8_t background[4096];
+alignas(4) uint8_t output[2][8192];     // Linked kernel, portable kernel.
+alignas(4) uint8_t table[512];          // Palettes, CLUTs, and font rows.
+alignas(4) uint8_t patterns[256 * 64];  // Tiles, or an affine texture.
+uint32_t lut[512];                      // For the 2bpp unpackers.
+
+uint32_t random_state = 0x2545F491;
+
+// xorshift32, so runs are repeatable everywhere.
+uint32_t next_random() {
+  random_state ^= random_state << 13;
+  random_state ^= random_state >> 17;
+  random_state ^= random_state << 5;
+  return random_state;
+}
+
+unsigned random_below(unsigned n) {
+  return next_random() % n;
+}
+
+void randomize(void *data, unsigned bytes, uint8_t mask = 0xFF) {
+  auto p = static_cast<uint8_t *>(data);
+  for (unsigned i = 0; i < bytes; ++i) p[i] = uint8_t(next_random()) & mask;
+}
+
+/*
+ * Fills all inputs with fresh random bytes.
+ */
+void randomize_inputs() {
+  randomize(input, sizeof(input));
+  randomize(background, sizeof(background));
+  randomize(table, sizeof(table));
+  randomize(patterns, sizeof(patterns));
+}
+
+/*
+ * Builds the 2bpp lookup table, and its mask half, as Bitmap_2 would from a
+ * random CLUT.
+ */
+void build_lut() {
+  uint8_t clut[4];
+  randomize(clut, sizeof(clut));
+  for (unsigned byte = 0; byte < 256; ++byte) {
+    uint32_t colors = 0, mask = 0;
+    for (unsigned i = 0; i < 4; ++i) {
+      unsigned index = (byte >> (i * 2)) & 3;
+      colors |= uint32_t(clut[index]) << (i * 8);
+      if (index == 0) mask |= uint32_t(0xFF) << (i * 8);
+    }
+    lut[byte] = colors;
+    lut[256 + byte] = mask;
+  }
+}
+
+/*
+ * Calls 'run' with the linked and then the portable version of a kernel, each
+ * rendering into its own copy of some random output, and checks that the
+ * results match.  'output_mask' limits the values in the random output, for
+ * kernels that look at it.  Returns the number of failures.
+ */
+template <typename Kernel, typename Run>
+unsigned compare(char const *name, unsigned trial,
+                 Kernel *linked, Kernel *reference,
+                 Run run,
+                 uint8_t output_mask = 0xFF) {
+  randomize(output[0], sizeof(output[0]), output_mask);
+  std::memcpy(output[1], output[0], sizeof(output[0]));
+
+  run(linked, output[0]);
+  run(reference, output[1]);
+
+  for (unsigned i = 0; i < sizeof(output[0]); ++i) {
+    if (output[0][i] != output[1][i]) {
+      std::printf("FAIL %s, trial %u: byte %u is %02X, expected %02X\n",
+                  name, trial, i, output[0][i], output[1][i]);
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/*
+ * Times 'run' with each version of a kernel, and prints the average cycles per
+ * call.
+ */
+template <typename Kernel, typename Run>
+void benchmark(char const *name, Kernel *linked, Kernel *reference, Run run) {
+  Kernel *kernels[2] = { linked, reference };
+  unsigned cycles[2];
+
+  for (unsigned k = 0; k < 2; ++k) {
+    run(kernels[k], output[k]);  // Warm up.
+
+    auto start = vga::backend::cycle_count();
+    for (unsigned i = 0; i < benchmark_reps; ++i) run(kernels[k], output[k]);
+    cycles[k] = (vga::backend::cycle_count() - start) / benchmark_reps;
+  }
+
+  std::printf("%-30s %8u %8u\n", name, cycles[0], cycles[1]);
+}
+
+unsigned check_copy_words() {
+  auto run_with = [](unsigned count) {
+    return [count](decltype(copy_words) *kernel, uint8_t *target) {
+      kernel(reinterpret_cast<Word const *>(input),
+             reinterpret_cast<Word *>(target),
+             count);
+    };
+  };
+
+  unsigned failures = 0;
+  for (unsigned t = 0; t < trials; ++t) {
+    randomize_inputs();
+    failures += compare("copy_words", t, copy_words, portable::copy_words,
+                        run_with(random_below(2049)));
+  }
+  benchmark("copy_words", copy_words, portable::copy_words, run_with(200));
+  return failures;
+}
+
+unsigned check_fill_pixels() {
+  auto run_with = [](unsigned offset, unsigned count, uint8_t color) {
+    return [=](decltype(rast::fill_pixels_impl) *kernel, uint8_t *target) {
+      kernel(target + offset, count, color);
+    };
+  };
+
+  unsigned failures = 0;
+  for (unsigned t = 0; t < trials; ++t) {
+    failures += compare("fill_pixels", t,
+                        rast::fill_pixels_impl, ref::fill_pixels_impl,
+                        run_with(random_below(4), random_below(2001),
+                                 uint8_t(next_random())));
+  }
+  benchmark("fill_pixels", rast::fill_pixels_impl, ref::fill_pixels_impl,
+            run_with(0, 800, 0x2A));
+  return failures;
+}
+
+unsigned check_merge_keyed() {
+  auto run_with = [](unsigned offset, unsigned source_offset,
+                     unsigned count, uint8_t key) {
+    return [=](decltype(rast::merge_keyed_impl) *kernel, uint8_t *target) {
+      kernel(target + offset, input + source_offset, count, key);
+    };
+  };
+
+  unsigned failures = 0;
+  for (unsigned t = 0; t < trials; ++t) {
+    randomize_inputs();
+    // Draw the output and key from four values, so that a quarter of the
+    // pixels match.
+    failures += compare("merge_keyed", t,
+                        rast::merge_keyed_impl, ref::merge_keyed_impl,
+                        run_with(random_below(4), random_below(4),
+                                 random_below(2001), uint8_t(random_below(4))),
+                        0x03);
+  }
+  benchmark("merge_keyed", rast::merge_keyed_impl, ref::merge_keyed_impl,
+            run_with(0, 0, 800, 0));
+  return failures;
+}
+
+unsigned check_unpack_1bpp() {
+  auto run_with = [](unsigned words) {
+    return [=](decltype(rast::unpack_1bpp_impl) *kernel, uint8_t *target) {
+      kernel(reinterpret_cast<uint32_t const *>(input), table, target, words);
+    };
+  };
+  auto run_overlay_with = [](unsigned words) {
+    return [=](decltype(rast::unpack_1bpp_overlay_impl) *kernel,
+               uint8_t *target) {
+      kernel(reinterpret_cast<uint32_t const *>(input), table, target, words,
+             background);
+    };
+  };
+
+  unsigned failures = 0;
+  for (unsigned t = 0; t < trials; ++t) {
+    randomize_inputs();
+    failures += compare("unpack_1bpp", t,
+                        rast::unpack_1bpp_impl, ref::unpack_1bpp_impl,
+                        run_with(1 + random_below(64)));
+    failures += compare("unpack_1bpp_overlay", t,
+                        rast::unpack_1bpp_overlay_impl,
+                        ref::unpack_1bpp_overlay_impl,
+                        run_overlay_with(1 + random_below(64)));
+  }
+  benchmark("unpack_1bpp", rast::unpack_1bpp_impl, ref::unpack_1bpp_impl,
+            run_with(25));
+  benchmark("unpack_1bpp_overlay",
+            rast::unpack_1bpp_overlay_impl, ref::unpack_1bpp_overlay_impl,
+            run_overlay_with(25));
+  return failures;
+}
+
+unsigned check_unpack_2bpp() {
+  auto run_with = [](unsigned words) {
+    return [=](decltype(rast::unpack_2bpp_impl) *kernel, uint8_t *target) {
+      kernel(reinterpret_cast<uint32_t const *>(input), lut, target, words);
+    };
+  };
+  auto run_overlay_with = [](unsigned words) {
+    return [=](decltype(rast::unpack_2bpp_overlay_impl) *kernel,
+               uint8_t *target) {
+      kernel(reinterpret_cast<uint32_t const *>(input), lut, target, words,
+             background);
+    };
+  };
+
+  unsigned failures = 0;
+  for (unsigned t = 0; t < trials; ++t) {
+    randomize_inputs();
+    build_lut();
+    failures += compare("unpack_2bpp", t,
+                        rast::unpack_2bpp_impl, ref::unpack_2bpp_impl,
+                        run_with(1 + random_below(128)));
+    failures += compare("unpack_2bpp_overlay", t,
+                        rast::unpack_2bpp_overlay_impl,
+                        ref::unpack_2bpp_overlay_impl,
+                        run_overlay_with(1 + random_below(128)));
+  }
+  benchmark("unpack_2bpp", rast::unpack_2bpp_impl, ref::unpack_2bpp_impl,
+            run_with(50));
+  benchmark("unpack_2bpp_overlay",
+            rast::unpack_2bpp_overlay_impl, ref::unpack_2bpp_overlay_impl,
+            run_overlay_with(50));
+  return failures;
+}
+
+unsigned check_unpack_affine() {
+  auto run_with = [](rast::AffineStep step, unsigned count) {
+    return [=](decltype(rast::unpack_affine_impl) *kernel, uint8_t *target) {
+      kernel(patterns, step, target, count);
+    };
+  };
+
+  unsigned failures = 0;
+  for (unsigned t = 0; t < trials; ++t) {
+    randomize_inputs();
+    // A random texture of 2^w by 2^h texels, no larger than 'patterns'.
+    unsigned w = 1 + random_below(7), h = 1 + random_below(7);
+    rast::AffineStep step = {
+      next_random(), next_random(), next_random(), next_random(),
+      32 - w, 32 - h - w, (1u << w) - 1,
+    };
+    failures += compare("unpack_affine", t,
+                        rast::unpack_affine_impl, ref::unpack_affine_impl,
+                        run_with(step, 4 * (1 + random_below(512))));
+  }
+  rast::AffineStep step = { 0, 0, 0x01000000, 0x00400000, 25, 18, 0x7F };
+  benchmark("unpack_affine", rast::unpack_affine_impl, ref::unpack_affine_impl,
+            run_with(step, 800));
+  return failures;
+}
+
+unsigned check_unpack_direct_rev() {
+  auto run_with = [](unsigned bytes) {
+    return [=](decltype(rast::unpack_direct_rev_impl) *kernel,
+               uint8_t *target) {
+      kernel(input + sizeof(input), target, bytes);
+    };
+  };
+
+  unsigned failures = 0;
+  for (unsigned t = 0; t < trials; ++t) {
+    randomize_inputs();
+    failures += compare("unpack_direct_rev", t,
+                        rast::unpack_direct_rev_impl,
+                        ref::unpack_direct_rev_impl,
+                        run_with(1 + random_below(2048)));
+  }
+  benchmark("unpack_direct_rev",
+            rast::unpack_direct_rev_impl, ref::unpack_direct_rev_impl,
+            run_with(800));
+  return failures;
+}
+
+unsigned check_unpack_palettes() {
+  auto run_p16_with = [](unsigned words) {
+    return [=](decltype(rast::unpack_p16_impl) *kernel, uint8_t *target) {
+      kernel(input, target, words, table);
+    };
+  };
+  auto run_p256_with = [](unsigned words) {
+    return [=](decltype(rast::unpack_p256_impl) *kernel, uint8_t *target) {
+      kernel(input, target, words, table);
+    };
+  };
+
+  unsigned failures = 0;
+  for (unsigned t = 0; t < trials; ++t) {
+    randomize_inputs();
+    failures += compare("unpack_p16", t,
+                        rast::unpack_p16_impl, ref::unpack_p16_impl,
+                        run_p16_with(1 + random_below(256)));
+    failures += compare("unpack_p256", t,
+                        rast::unpack_p256_impl, ref::unpack_p256_impl,
+                        run_p256_with(1 + random_below(512)));
+  }
+  benchmark("unpack_p16", rast::unpack_p16_impl, ref::unpack_p16_impl,
+            run_p16_with(100));
+  benchmark("unpack_p256", rast::unpack_p256_impl, ref::unpack_p256_impl,
+            run_p256_with(200));
+  return failures;
+}
+
+unsigned check_unpack_lerp() {
+  auto run_lerp4_with = [](unsigned bytes) {
+    return [=](decltype(rast::unpack_p256_lerp4_impl) *kernel,
+               uint8_t *target) {
+      kernel(input, target, bytes, table);
+    };
+  };
+  auto run_lerp4_d4_with = [](unsigned bytes) {
+    return [=](decltype(rast::unpack_p256_lerp4_d4_impl) *kernel,
+               uint8_t *target) {
+      kernel(input, target, bytes, table, table + 256);
+    };
+  };
+
+  unsigned failures = 0;
+  for (unsigned t = 0; t < trials; ++t) {
+    randomize_inputs();
+    failures += compare("unpack_p256_lerp4", t,
+                        rast::unpack_p256_lerp4_impl,
+                        ref::unpack_p256_lerp4_impl,
+                        run_lerp4_with(2 + random_below(512)));
+    failures += compare("unpack_p256_lerp4_d4", t,
+                        rast::unpack_p256_lerp4_d4_impl,
+                        ref::unpack_p256_lerp4_d4_impl,
+                        run_lerp4_d4_with(2 + random_below(256)));
+  }
+  benchmark("unpack_p256_lerp4",
+            rast::unpack_p256_lerp4_impl, ref::unpack_p256_lerp4_impl,
+            run_lerp4_with(201));
+  benchmark("unpack_p256_lerp4_d4",
+            rast::unpack_p256_lerp4_d4_impl, ref::unpack_p256_lerp4_d4_impl,
+            run_lerp4_d4_with(51));
+  return failures;
+}
+
+/*
+ * The text kernels share a signature, so they share a check.  Input cells are
+ * random, with random attributes; the mask selects random attribute bits, as
+ * Text's does.
+ */
+template <typename Kernel>
+unsigned check_unpack_text(char const *name,
+                           Kernel *linked, Kernel *reference,
+                           unsigned cell_width) {
+  auto run_with = [](unsigned cols, unsigned mask) {
+    return [=](Kernel *kernel, uint8_t *target) {
+      kernel(input, table, target, cols, mask);
+    };
+  };
+
+  unsigned failures = 0;
+  for (unsigned t = 0; t < trials; ++t) {
+    randomize_inputs();
+    failures += compare(name, t, linked, reference,
+                        run_with(1 + random_below(200),
+                                 next_random() & 0x07000000));
+  }
+  benchmark(name, linked, reference, run_with(800 / cell_width, 0x07000000));
+  return failures;
+}
+
+unsigned check_unpack_tile8() {
+  auto run_with = [](unsigned row, unsigned offset, unsigned tiles) {
+    return [=](decltype(rast::unpack_tile8_impl) *kernel, uint8_t *target) {
+      kernel(input, patterns + row * 8, target + offset, tiles);
+    };
+  };
+
+  unsigned failures = 0;
+  for (unsigned t = 0; t < trials; ++t) {
+    randomize_inputs();
+    failures += compare("unpack_tile8", t,
+                        rast::unpack_tile8_impl, ref::unpack_tile8_impl,
+                        run_with(random_below(8), random_below(4),
+                                 random_below(257)));
+  }
+  benchmark("unpack_tile8", rast::unpack_tile8_impl, ref::unpack_tile8_impl,
+            run_with(0, 0, 100));
+  return failures;
+}
+
+}  // namespace
+
+int main() {
+  // The cycle counter needs a Timing, even without video.
+  vga::init();
+  vga::configure_timing(vga::timing_vesa_800x600_60hz);
+
+  std::printf("%-30s %8s %8s\n", "cycles per ~800 pixels", "linked", "portable");
+
+  unsigned failures = 0;
+  failures += check_copy_words();
+  failures += check_fill_pixels();
+  failures += check_merge_keyed();
+  failures += check_unpack_1bpp();
+  failures += check_unpack_2bpp();
+  failures += check_unpack_affine();
+  failures += check_unpack_direct_rev();
+  failures += check_unpack_palettes();
+  failures += check_unpack_lerp();
+  failures += check_unpack_text("unpack_text_10p_attributed",
+                                rast::unpack_text_10p_attributed_impl,
+                                ref::unpack_text_10p_attributed_impl,
+                                10);
+  failures += check_unpack_text("unpack_text_8p_attributed",
+                                rast::unpack_text_8p_attributed_impl,
+                                ref::unpack_text_8p_attributed_impl,
+                                8);
+  failures += check_unpack_text("unpack_text_6p_attributed",
+                                rast::unpack_text_6p_attributed_impl,
+                                ref::unpack_text_6p_attributed_impl,
+                                6);
+  failures += check_unpack_tile8();
+
+  if (failures) std::printf("%u failures\n", failures);
+  return failures ? 1 : 0;
+}
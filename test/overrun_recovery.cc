@@ -0,0 +1,113 @@
+/*
+ * Checks that a single rasterizer overrun costs about one line, rather than
+ * leaving the driver behind scanout for the rest of the frame.
+ *
+ * The simulator runs hblank work to completion, so to overrun, the rasterizer
+ * advances the line clock itself -- just as, on hardware, EAV would preempt
+ * it.
+ *
+ * Runs against vga_sim; exits nonzero on failure.
+ */
+
+#include <cstdio>
+
+#include "vga/rasterizer.h"
+#include "vga/sim.h"
+#include "vga/timing.h"
+#include "vga/vga.h"
+
+using vga::Rasterizer;
+
+namespace {
+
+constexpr unsigned width = 800, height = 600;
+constexpr unsigned overrun_line = 100;
+
+// The most lines a single overrun may cost: the one it overlapped, and one
+// for slack.  With a deep enough lookahead ring it costs none.
+constexpr unsigned max_lines_lost = 2;
+
+Rasterizer::Pixel line_color(unsigned line) {
+  return Rasterizer::Pixel(line % 63 + 1);
+}
+
+/*
+ * Fills each line with a color derived from its number, overrunning once on
+ * request.
+ */
+class Striped : public Rasterizer {
+public:
+  bool overrun_pending = false;
+
+  RasterInfo rasterize(unsigned cycles_per_pixel,
+                       unsigned line_number,
+                       Pixel *target) override {
+    if (overrun_pending && line_number == overrun_line) {
+      overrun_pending = false;
+      vga::sim::step_line();
+    }
+
+    for (unsigned i = 0; i < width; ++i) target[i] = line_color(line_number);
+    return { 0, width, cycles_per_pixel, 0 };
+  }
+};
+
+Striped striped;
+vga::Band const band = { &striped, height, nullptr };
+
+/*
+ * Draws one frame with an overrun under the given policy, and checks how many
+ * lines were lost.  Returns the number of failures.
+ */
+unsigned check_policy(vga::OverrunPolicy policy, char const *name) {
+  vga::set_overrun_policy(policy);
+
+  striped.overrun_pending = true;
+  vga::sim::step_frame();
+
+  auto stats = vga::get_frame_stats();
+  auto frame = vga::sim::get_frame();
+
+  unsigned wrong = 0;
+  for (unsigned y = 0; y < height; ++y) {
+    if (frame[y * width] != line_color(y)) ++wrong;
+  }
+
+  std::printf("%s: %u late, %u wrong\n", name, stats.lines_late, wrong);
+
+  unsigned failures = 0;
+  if (striped.overrun_pending) {
+    std::printf("FAIL %s: overrun didn't happen\n", name);
+    ++failures;
+  }
+  if (stats.lines_late > max_lines_lost) {
+    std::printf("FAIL %s: expected at most %u late lines\n",
+                name, max_lines_lost);
+    ++failures;
+  }
+  if (wrong > max_lines_lost) {
+    std::printf("FAIL %s: expected at most %u wrong lines\n",
+                name, max_lines_lost);
+    ++failures;
+  }
+  return failures;
+}
+
+}  // namespace
+
+int main() {
+  vga::init();
+  vga::configure_band_list(&band);
+  vga::configure_timing(vga::timing_vesa_800x600_60hz);
+  vga::video_on();
+
+  // Settle into a steady frame first.
+  vga::sim::step_frame();
+  vga::sim::step_frame();
+
+  unsigned failures = 0;
+  failures += check_policy(vga::OverrunPolicy::blank, "blank");
+  failures += check_policy(vga::OverrunPolicy::repeat, "repeat");
+
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,168 @@
+/*
+ * Checks that a Terminal scrolling several rows within one frame doesn't
+ * disturb the frame being displayed.
+ *
+ * The Text's ring can only scroll one row per frame without reusing a row
+ * that frame still shows, so further scrolls must fall back to copying.  To
+ * catch a reused row, this fills the screen with numbered lines, runs the line
+ * clock partway into a frame, writes three more, and reads the text back from
+ * the frame: it should show the lines in the order they were written.  At
+ * 800x600 the last row of cells is cut off, so this also checks that the
+ * Terminal's bottom row -- where new text appears -- is shown in full.
+ *
+ * Runs against vga_sim; exits nonzero on failure.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "vga/sim.h"
+#include "vga/terminal.h"
+#include "vga/timing.h"
+#include "vga/vga.h"
+
+using vga::rast::Text_10x16;
+
+namespace {
+
+constexpr unsigned width = 800, height = 600;
+constexpr unsigned cell_width = Text_10x16::cell_width;
+constexpr unsigned cell_height = Text_10x16::cell_height;
+
+// How far into the displayed frame to write: partway down the top row.
+constexpr unsigned write_line = 8;
+
+// Each glyph row holds its character code, so the text can be read back from
+// the frame.
+std::uint8_t font[256 * cell_height];
+
+/*
+ * Returns the text shown on a line of the last frame, less trailing blanks.
+ * Terminal's default colors draw the background as zero, and blank cells read
+ * back as spaces or NULs.
+ */
+std::string shown_text(unsigned y) {
+  auto pixels = vga::sim::get_frame() + y * width;
+  std::string text;
+  for (unsigned x = 0; x + cell_width <= width; x += cell_width) {
+    unsigned c = 0;
+    for (unsigned i = 0; i < 8; ++i) c |= unsigned(pixels[x + i] != 0) << i;
+    text += char(c);
+  }
+  auto end = text.find_last_not_of(std::string(" \0", 2));
+  text.erase(end == std::string::npos ? 0 : end + 1);
+  return text;
+}
+
+/*
+ * Ranks text in the order it was written: "line N" by N, then single letters,
+ * then blank rows.
+ */
+unsigned write_order(std::string const &text) {
+  if (text.empty()) return ~0u;
+  if (text.compare(0, 5, "line ") == 0) return std::atoi(text.c_str() + 5);
+  if (text.size() == 1) return 1000 + text[0];
+  return ~0u - 1;
+}
+
+/*
+ * Checks that the last frame, from 'first_line' down, shows text in the order
+ * it was written.  Returns the number of failures.
+ */
+unsigned check_order(char const *when, unsigned first_line,
+                     unsigned text_lines) {
+  unsigned last = 0;
+  for (unsigned y = first_line; y < text_lines; ++y) {
+    auto text = shown_text(y);
+    auto order = write_order(text);
+    if (order == ~0u - 1 || order < last) {
+      std::printf("FAIL %s: line %u shows \"%s\" out of order\n",
+                  when, y, text.c_str());
+      return 1;
+    }
+    last = order;
+  }
+  return 0;
+}
+
+}  // namespace
+
+int main() {
+  for (unsigned row = 0; row < cell_height; ++row) {
+    for (unsigned c = 0; c < 256; ++c) font[row * 256 + c] = std::uint8_t(c);
+  }
+
+  vga::init();
+
+  Text_10x16 text(font, 256, width, height);
+  vga::Terminal<Text_10x16> terminal(text);
+  vga::Band const band = { &text, height, nullptr };
+
+  vga::configure_band_list(&band);
+  vga::configure_timing(vga::timing_vesa_800x600_60hz);
+  vga::video_on();
+
+  unsigned const rows = text.get_full_row_count();
+  unsigned const text_lines = rows * cell_height;
+
+  // Fill every row, leaving the cursor on the last.
+  for (unsigned row = 0; row < rows; ++row) {
+    char line[24];
+    std::snprintf(line, sizeof(line), "\nline %u", row);
+    terminal.write(row ? line : line + 1);
+  }
+  vga::sim::step_frame();
+  vga::sim::step_frame();
+
+  unsigned failures = check_order("filled", 0, text_lines);
+
+  // A single scroll should still move the ring.
+  terminal.write("\nA");
+  if (!text.is_scroll_pending()) {
+    std::printf("FAIL first scroll in a frame didn't use the ring\n");
+    ++failures;
+  }
+  vga::sim::step_frame();
+
+  // Scroll three times partway into a frame.
+  auto const &timing = vga::timing_vesa_800x600_60hz;
+  for (unsigned i = 0; i < timing.video_start_line + write_line; ++i) {
+    vga::sim::step_line();
+  }
+  terminal.write("\nB\nC\nD");
+  vga::sim::step_frame();
+  failures += check_order("scrolling", 0, text_lines);
+
+  // By the next frame, the text should have moved up by four rows in all.
+  vga::sim::step_frame();
+  failures += check_order("scrolled", 0, text_lines);
+
+  if (shown_text(0) != "line 4") {
+    std::printf("FAIL top row shows \"%s\", not line 4\n",
+                shown_text(0).c_str());
+    ++failures;
+  }
+  // The newest text should be on the bottom row, all of which is shown, with
+  // nothing below it.
+  for (unsigned y = text_lines - cell_height; y < height; ++y) {
+    auto shown = shown_text(y);
+    if (shown != (y < text_lines ? "D" : "")) {
+      std::printf("FAIL line %u shows \"%s\"\n", y, shown.c_str());
+      ++failures;
+      break;
+    }
+  }
+
+  char const expected[] = "ABCD";
+  for (unsigned i = 0; i < 4; ++i) {
+    unsigned row = rows - 4 + i;
+    if ((text.get_row_cells(row)[0] & 0xFF) != std::uint8_t(expected[i])) {
+      std::printf("FAIL row %u should start with %c\n", row, expected[i]);
+      ++failures;
+    }
+  }
+
+  return failures ? 1 : 0;
+}
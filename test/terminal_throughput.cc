@@ -0,0 +1,89 @@
+/*
+ * Measures how fast a Terminal interprets a log-like stream -- lines of text
+ * with a few SGR color changes -- in characters per second of host time.
+ *
+ * Each line scrolls the display.  Two cases bound the cost of that:
+ *  - a burst, all within one frame, so every scroll after the first copies
+ *    rows (see Terminal::scroll_up);
+ *  - one line per frame, so every scroll moves the Text's ring.  Only the
+ *    writes are timed, not the simulated frames between them.
+ *
+ * Host and hardware speeds differ, so use this to compare changes to
+ * Terminal, not to predict throughput on the target.
+ *
+ * Runs against vga_sim.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+#include "vga/sim.h"
+#include "vga/terminal.h"
+#include "vga/timing.h"
+#include "vga/vga.h"
+
+using vga::rast::Text_10x16;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+constexpr unsigned width = 800, height = 600;
+
+char const log_line[] =
+  "\x1b[32m[ ok ]\x1b[0m sensor 12 reading 0x3f7a within tolerance, "
+  "t=123456 ms\n";
+constexpr unsigned log_line_length = sizeof(log_line) - 1;
+
+constexpr unsigned burst_lines = 200000;
+constexpr unsigned frame_lines = 2000;
+
+std::uint8_t font[256 * Text_10x16::cell_height];
+
+void report(char const *name, unsigned lines, Clock::duration time) {
+  double seconds = std::chrono::duration<double>(time).count();
+  double chars = double(lines) * log_line_length;
+  std::printf("%-20s %8.1f million chars/s (%u lines in %.3f s)\n",
+              name, chars / seconds / 1e6, lines, seconds);
+}
+
+}  // namespace
+
+int main() {
+  vga::init();
+
+  Text_10x16 text(font, 256, width, height);
+  vga::Terminal<Text_10x16> terminal(text);
+  vga::Band const band = { &text, height, nullptr };
+
+  vga::configure_band_list(&band);
+  vga::configure_timing(vga::timing_vesa_800x600_60hz);
+  vga::video_on();
+  vga::sim::step_frame();
+
+  // A burst: many lines per write, with no frames in between.
+  constexpr unsigned lines_per_write = 100;
+  static char chunk[lines_per_write * log_line_length];
+  for (unsigned i = 0; i < lines_per_write; ++i) {
+    std::memcpy(chunk + i * log_line_length, log_line, log_line_length);
+  }
+
+  auto start = Clock::now();
+  for (unsigned i = 0; i < burst_lines / lines_per_write; ++i) {
+    terminal.write(chunk, sizeof(chunk));
+  }
+  report("burst", burst_lines, Clock::now() - start);
+
+  // One line per frame.
+  vga::sim::step_frame();
+  Clock::duration writing{};
+  for (unsigned i = 0; i < frame_lines; ++i) {
+    auto line_start = Clock::now();
+    terminal.write(log_line, log_line_length);
+    writing += Clock::now() - line_start;
+    vga::sim::step_frame();
+  }
+  report("one line per frame", frame_lines, writing);
+
+  return 0;
+}
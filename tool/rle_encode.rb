@@ -0,0 +1,110 @@
+#!/usr/bin/ruby
+#
+# Encodes an image for vga::rast::Rle, emitting C++ source that defines a
+# vga::rast::RleImage.
+#
+# Usage: rle_encode.rb input.pnm symbol_name > output.cc
+#
+# Input is a binary PGM (P5) or PPM (P6) with a maxval of 255.  PGM samples
+# are used directly as pixels (or palette indices); PPM colors are reduced to
+# the 2-2-2 RGB format of palette64.gpl.
+
+def read_token(io)
+  token = ''
+  loop {
+    c = io.read(1)
+    raise "unexpected end of header" if c.nil?
+    if c == '#'
+      io.gets
+    elsif c =~ /\s/
+      return token unless token.empty?
+    else
+      token << c
+    end
+  }
+end
+
+def read_pnm(path)
+  File.open(path, 'rb') { |io|
+    magic = read_token(io)
+    raise "#{path}: expected P5 or P6, got #{magic}" unless %w(P5 P6).include?(magic)
+    width = read_token(io).to_i
+    height = read_token(io).to_i
+    maxval = read_token(io).to_i
+    raise "#{path}: maxval must be 255" unless maxval == 255
+
+    if magic == 'P5'
+      pixels = io.read(width * height).bytes
+    else
+      pixels = io.read(width * height * 3).bytes.each_slice(3).map { |r, g, b|
+        ((r >> 6) << 4) | ((g >> 6) << 2) | (b >> 6)
+      }
+    end
+    [width, height, pixels]
+  }
+end
+
+# Encodes one line as packets; see rle.h.
+def encode_line(line)
+  out = []
+  literal = []
+  flush = lambda {
+    literal.each_slice(128) { |chunk|
+      out << chunk.length - 1
+      out.concat(chunk)
+    }
+    literal = []
+  }
+
+  i = 0
+  while i < line.length
+    run = 1
+    run += 1 while i + run < line.length && line[i + run] == line[i]
+    if run >= 2
+      flush.call
+      run.times.each_slice(128) { |chunk|
+        out << (0x80 | (chunk.length - 1))
+        out << line[i]
+      }
+    else
+      literal << line[i]
+    end
+    i += run
+  end
+  flush.call
+  out
+end
+
+abort "usage: #{$0} input.pnm symbol_name" unless ARGV.length == 2
+path, name = ARGV
+
+width, height, pixels = read_pnm(path)
+
+data = []
+offsets = []
+seen = {}
+pixels.each_slice(width) { |line|
+  encoded = encode_line(line)
+  # Identical lines share data, which the rasterizer turns into repeats.
+  offsets << (seen[encoded] ||= data.length.tap { data.concat(encoded) })
+}
+
+puts "// Generated by rle_encode.rb from #{File.basename(path)}; do not edit."
+puts "// #{width}x#{height} pixels, #{data.length} bytes of data."
+puts
+puts '#include "vga/rast/rle.h"'
+puts
+puts "static std::uint32_t const #{name}_line_offsets[#{height}] = {"
+offsets.each_slice(8) { |s| puts '  ' + s.join(', ') + ',' }
+puts '};'
+puts
+puts "static std::uint8_t const #{name}_data[#{data.length}] = {"
+data.each_slice(12) { |s| puts '  ' + s.map { |b| '0x%02X' % b }.join(', ') + ',' }
+puts '};'
+puts
+puts "extern vga::rast::RleImage const #{name} = {"
+puts "  #{width},"
+puts "  #{height},"
+puts "  #{name}_line_offsets,"
+puts "  #{name}_data,"
+puts '};'
@@ -0,0 +1,114 @@
+#include "vga/vblank.h"
+
+#include "vga/backend.h"
+
+namespace vga {
+
+/*******************************************************************************
+ * Scheduler state.
+ */
+
+// Jobs submitted since the driver last looked, most recent first.  This is a
+// lock-free stack so that jobs can be submitted from any priority level.
+static std::atomic<VblankJob *> submitted{nullptr};
+
+// Jobs the driver has taken from 'submitted' but not yet run, in the order it
+// will consider them.  Driver-only.
+static VblankJob *ready;
+
+static VblankStats stats;
+
+
+/*******************************************************************************
+ * Scheduler API.
+ */
+
+bool submit_vblank_job(VblankJob &job) {
+  if (job._queued.exchange(true)) return false;
+
+  auto head = submitted.load(std::memory_order_relaxed);
+  do {
+    job._next = head;
+  } while (!submitted.compare_exchange_weak(head, &job,
+                                            std::memory_order_release,
+                                            std::memory_order_relaxed));
+  return true;
+}
+
+VblankStats get_vblank_stats() {
+  return stats;
+}
+
+void reset_vblank_stats() {
+  // Naming only the budget in an initializer would leave the other fields to
+  // -Wmissing-field-initializers.
+  auto budget = stats.budget_cycles;
+  stats = {};
+  stats.budget_cycles = budget;
+}
+
+void run_vblank_jobs(unsigned budget_cycles) {
+  // Move newly submitted jobs into the ready list, keeping it sorted by
+  // priority, and FIFO within each priority.
+  auto incoming = submitted.exchange(nullptr, std::memory_order_acquire);
+
+  // The submitted stack is LIFO; reverse it so that inserting in order below
+  // preserves submission order.
+  VblankJob *fifo = nullptr;
+  while (incoming) {
+    auto next = incoming->_next;
+    incoming->_next = fifo;
+    fifo = incoming;
+    incoming = next;
+  }
+
+  while (fifo) {
+    auto next = fifo->_next;
+
+    auto link = &ready;
+    while (*link && (*link)->_priority >= fifo->_priority) {
+      link = &(*link)->_next;
+    }
+    fifo->_next = *link;
+    *link = fifo;
+
+    fifo = next;
+  }
+
+  stats.budget_cycles = budget_cycles;
+
+  auto start = backend::cycle_count();
+  unsigned used = 0;
+  bool ran_any = false;
+
+  while (ready) {
+    auto job = ready;
+
+    // Always run at least one job per vblank, even if its estimate is larger
+    // than the whole budget; otherwise it would never run.  Beyond that, stop
+    // at the first job that doesn't fit, rather than letting smaller jobs of
+    // lower priority jump ahead of it indefinitely.
+    if (ran_any && (used > budget_cycles
+                    || job->_estimated_cycles > budget_cycles - used)) {
+      break;
+    }
+
+    ready = job->_next;
+    job->_next = nullptr;
+    // Clear the queued flag before running, so the job can resubmit itself.
+    job->_queued = false;
+    job->_function(job->_arg);
+    ++stats.jobs_run;
+
+    ran_any = true;
+    used = backend::cycle_count() - start;
+  }
+
+  for (auto job = ready; job; job = job->_next) ++stats.jobs_deferred;
+
+  stats.used_cycles = used;
+  if (used > stats.peak_used_cycles) stats.peak_used_cycles = used;
+  if (used > budget_cycles) ++stats.overruns;
+}
+
+}  // namespace vga
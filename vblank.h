@@ -0,0 +1,117 @@
+#ifndef VGA_VBLANK_H
+#define VGA_VBLANK_H
+
+#include <atomic>
+
+namespace vga {
+
+/*
+ * A unit of work to be done during vertical blank, e.g. flipping pages,
+ * uploading a palette, or blitting sprites into a back buffer.
+ *
+ * Rather than spinning in wait_for_vblank and doing such work by hand, an
+ * application can submit VblankJobs.  The driver runs them in PendSV from the
+ * start of vertical blank, highest priority first, for as long as their
+ * estimated costs fit in what's left of the vertical blanking interval.  Jobs
+ * that don't fit are deferred to the next frame.  This turns the blank lines
+ * at the top of each frame into schedulable capacity.
+ *
+ * Each submission runs the job once.  A job that needs to run every frame can
+ * resubmit itself; it will run again at the next vertical blank.
+ *
+ * Jobs run at the same priority as rasterization, so video timing continues
+ * while they run, but the application's vga_hblank_interrupt does not: any
+ * hblank interrupts that fall during the jobs are skipped.
+ *
+ * VblankJobs are intrusively linked, so the driver never allocates.  The
+ * application owns them, and must not destroy a job while it's queued.
+ */
+class VblankJob {
+public:
+  using Function = void (*)(void *);
+
+  /*
+   * Creates a job that calls 'function(arg)'.  Higher 'priority' runs first;
+   * jobs of equal priority run in submission order.  'estimated_cycles' is the
+   * worst-case CPU time the job needs, which the driver uses to decide whether
+   * it fits.  (A job at the head of the queue runs even if its estimate exceeds
+   * the whole budget, rather than never running; expect it to disturb the top
+   * of the next frame.)
+   */
+  VblankJob(Function function, void *arg,
+            unsigned priority, unsigned estimated_cycles)
+    : _function(function),
+      _arg(arg),
+      _priority(priority),
+      _estimated_cycles(estimated_cycles),
+      _next(nullptr),
+      _queued(false) {}
+
+  /*
+   * Checks whether the job has been submitted and not yet run.
+   */
+  bool is_queued() const { return _queued; }
+
+  unsigned get_priority() const { return _priority; }
+  unsigned get_estimated_cycles() const { return _estimated_cycles; }
+
+  /*
+   * Alters the estimate, e.g. because the job's workload has changed.  Safe to
+   * call while the job is queued; takes effect the next time the driver
+   * considers it.
+   */
+  void set_estimated_cycles(unsigned c) { _estimated_cycles = c; }
+
+private:
+  Function _function;
+  void *_arg;
+  unsigned _priority;
+  unsigned volatile _estimated_cycles;
+  VblankJob *_next;
+  std::atomic<bool> _queued;
+
+  friend bool submit_vblank_job(VblankJob &);
+  friend void run_vblank_jobs(unsigned);
+};
+
+/*
+ * Queues a job to run at the next vertical blank (or, if it doesn't fit there,
+ * a later one).  Safe to call from any context, including interrupts and
+ * VblankJobs themselves.
+ *
+ * Returns false, and does nothing, if the job is already queued.
+ */
+bool submit_vblank_job(VblankJob &);
+
+/*
+ * Accounting for the vertical blank job scheduler.
+ */
+struct VblankStats {
+  unsigned budget_cycles;     // CPU time available to jobs per vblank.
+  unsigned used_cycles;       // CPU time used by jobs in the last vblank.
+  unsigned peak_used_cycles;  // Most CPU time used by jobs in any vblank.
+  unsigned jobs_run;          // Jobs completed.
+  unsigned jobs_deferred;     // Times a job was put off to a later vblank.
+  unsigned overruns;          // Vblanks in which jobs exceeded the budget.
+};
+
+/*
+ * Returns the scheduler's accounting since the last call to configure_timing
+ * or reset_vblank_stats.
+ */
+VblankStats get_vblank_stats();
+
+/*
+ * Zeroes the scheduler's accounting (except the budget).
+ */
+void reset_vblank_stats();
+
+/*
+ * Runs queued jobs within the given budget.  Used by the driver at the start
+ * of vertical blank; applications don't need to call this.
+ */
+void run_vblank_jobs(unsigned budget_cycles);
+
+}  // namespace vga
+
+#endif  // VGA_VBLANK_H
@@ -4,65 +4,56 @@
 #include <cstddef>
 #include <cstdint>
 
-#include "etl/assert.h"
-#include "etl/attribute_macros.h"
 #include "etl/prediction.h"
 
-#include "etl/armv7m/exceptions.h"
-#include "etl/armv7m/exception_table.h"
-#include "etl/armv7m/instructions.h"
-#include "etl/armv7m/scb.h"
 #include "etl/armv7m/types.h"
 
-#include "etl/stm32f4xx/adv_timer.h"
-#include "etl/stm32f4xx/ahb.h"
-#include "etl/stm32f4xx/apb.h"
-#include "etl/stm32f4xx/dbg.h"
-#include "etl/stm32f4xx/dma.h"
-#include "etl/stm32f4xx/flash.h"
-#include "etl/stm32f4xx/gpio.h"
-#include "etl/stm32f4xx/gp_timer.h"
-#include "etl/stm32f4xx/interrupts.h"
-#include "etl/stm32f4xx/interrupt_table.h"
-#include "etl/stm32f4xx/rcc.h"
-#include "etl/stm32f4xx/syscfg.h"
-
 #include "vga/arena.h"
+#include "vga/backend.h"
+#include "vga/copper.h"
 #include "vga/copy_words.h"
+#include "vga/profile.h"
 #include "vga/rasterizer.h"
 #include "vga/timing.h"
+#include "vga/vblank.h"
 
 using std::size_t;
 
-using etl::armv7m::Byte;
-using etl::armv7m::HalfWord;
-using etl::armv7m::scb;
-using etl::armv7m::Scb;
 using etl::armv7m::Word;
 
-using etl::stm32f4xx::AdvTimer;
-using etl::stm32f4xx::AhbPeripheral;
-using etl::stm32f4xx::ApbPeripheral;
-using etl::stm32f4xx::dbg;
-using etl::stm32f4xx::Dbg;
-using etl::stm32f4xx::Dma;
-using etl::stm32f4xx::dma2;
-using etl::stm32f4xx::flash;
-using etl::stm32f4xx::Gpio;
-using etl::stm32f4xx::gpiob;
-using etl::stm32f4xx::gpioe;
-using etl::stm32f4xx::GpTimer;
-using etl::stm32f4xx::Interrupt;
-using etl::stm32f4xx::rcc;
-using etl::stm32f4xx::syscfg;
-using etl::stm32f4xx::tim1;
-using etl::stm32f4xx::tim3;
-using etl::stm32f4xx::tim4;
-
-#define IN_SCAN_RAM ETL_SECTION(".vga_scan_ram")
-#define IN_LOCAL_RAM ETL_SECTION(".vga_local_ram")
-
-#define RAM_CODE ETL_SECTION(".ramcode")
+/*
+ * When nonzero, the working buffers live in DMA-capable RAM and are scanned out
+ * in place, instead of being copied into a separate scan buffer at EAV.  This
+ * takes the copy -- up to 800 bytes per line, on the AHB, right before SAV --
+ * out of the critical path, at the cost of moving the whole lookahead ring into
+ * scan RAM.  Rasterizers are unaffected.
+ *
+ * The buffer being scanned out can't be rasterized into until its line ends, so
+ * this mode requires at least two working buffers.
+ */
+#ifndef VGA_ZERO_COPY_SCANOUT
+#define VGA_ZERO_COPY_SCANOUT 0
+#endif
+
+/*
+ * Number of working buffers in the rasterization lookahead ring.  With one,
+ * the driver rasterizes exactly one line ahead of scanout.  Each additional
+ * buffer costs about 830 bytes of RAM and lets the driver run one line further
+ * ahead.  See get_lookahead_stats for help choosing a value.
+ */
+#ifndef VGA_LOOKAHEAD_LINES
+#if VGA_ZERO_COPY_SCANOUT
+#define VGA_LOOKAHEAD_LINES 2
+#else
+#define VGA_LOOKAHEAD_LINES 1
+#endif
+#endif
+
+#if VGA_ZERO_COPY_SCANOUT
+#define IN_WORKING_RAM IN_SCAN_RAM
+#else
+#define IN_WORKING_RAM IN_LOCAL_RAM
+#endif
 
 namespace vga {
 
@@ -73,23 +64,17 @@ namespace vga {
 static constexpr unsigned
   // Used to adjust size of scan_buffer.
   max_pixels_per_line = 800,
-  // Fudge factor: shifts timer-initiated DRQ back in time by this many cycles,
-  // to delay DRQ until DMA has started.
-  drq_shift_cycles = 2,
-  // Fudge factor: how long the shock absorber IRQ should lead the actual start
-  // of video IRQ, in cycles.
-  shock_absorber_shift_cycles = 20,
   // Amount of pad to place on either side of the working buffer, so that lazy
   // rasterizers can scribble slightly outside the lines -- in words.
-  extra_pad_words = 4;
+  extra_pad_words = Rasterizer::max_overrun / sizeof(Word),
+  // Number of working buffers in the lookahead ring.
+  lookahead_lines = VGA_LOOKAHEAD_LINES,
+  // Blank pixels following each working buffer, if it's scanned out in place.
+  working_tail_pixels = VGA_ZERO_COPY_SCANOUT ? sizeof(Word) : 0;
 
-// Common fields used in scanout DMA transfer settings.
-static constexpr auto dma_xfer_common = Dma::Stream::cr_value_t()
-  .with_chsel(6)  // for TIM1_UP
-  .with_pl(Dma::Stream::cr_value_t::pl_t::very_high)
-  .with_pburst(Dma::Stream::BurstSize::single)
-  .with_mburst(Dma::Stream::BurstSize::single)
-  .with_en(true);
+static_assert(lookahead_lines > 0, "VGA_LOOKAHEAD_LINES must be at least 1");
+static_assert(!VGA_ZERO_COPY_SCANOUT || lookahead_lines > 1,
+              "VGA_ZERO_COPY_SCANOUT requires VGA_LOOKAHEAD_LINES >= 2");
 
 
 /*******************************************************************************
@@ -126,69 +111,178 @@ inline bool is_rendered_state(State s) {
 // Finally, the actual variable.
 static State volatile state;
 
-// This is the DMA source for scan-out, copied from the working buffer during
-// pend_sv.  It must be located in DMA-capable RAM, and is aligned to allow for
-// word-sized DMA reads.
+#if !VGA_ZERO_COPY_SCANOUT
+// This is the DMA source for scan-out, copied from the lookahead ring at EAV.
+// It must be located in DMA-capable RAM, and is aligned to allow for word-sized
+// DMA reads.
 //
 // It contains an extra word's worth of pixels to ensure that we can follow
 // every line with an extra transfer to blank the outputs.  The extra pixels
-// are blanked after the rasterizer returns.
+// are blanked after each copy.
 alignas(Word) IN_SCAN_RAM
 static Pixel scan_buffer[max_pixels_per_line + sizeof(Word)];
+#endif
 
-// This is the working buffer, the target of the Rasterizer.  Its contents will
-// be copied to the scan_buffer during hblank if needed.  It need not be in
-// DMA-capable RAM.
+// A word of blank pixels, scanned out in place of a line that wasn't ready in
+// time.
+alignas(Word) IN_SCAN_RAM
+static Pixel blank_pixels[sizeof(Word)];
+
+// These are the working buffers, the targets of the Rasterizer, arranged as a
+// ring.  Normally their contents are copied to the scan_buffer at EAV before
+// the line they describe, and they need not be in DMA-capable RAM.  In
+// zero-copy mode they're scanned out directly, and so must be, and each is
+// followed by a word of blank pixels like the scan_buffer.
 //
-// It's aligned so we can use a high-speed word copy routine.
+// They're aligned so we can use a high-speed word copy routine.
 //
-// It has invisible padding at either end because it makes certain tile
+// They have invisible padding at either end because it makes certain tile
 // scrolling algorithms simpler to implement if they need not color precisely
 // within the lines.
-alignas(Word) IN_LOCAL_RAM
+alignas(Word) IN_WORKING_RAM
 static struct {
   Word left_pad[extra_pad_words];
-  Pixel buffer[max_pixels_per_line];
+  Pixel buffer[max_pixels_per_line + working_tail_pixels];
   Word right_pad[extra_pad_words];
-} working;
-
-// A description of the contents of the working buffer, produced by the last
-// Rasterizer that was applied.  This is used to adjust the output timings.
-static Rasterizer::RasterInfo working_buffer_shape;
+} working[lookahead_lines];
+
+// A description of the contents of each working buffer: the RasterInfo
+// produced by the Rasterizer, the run of visible lines it covers, which
+// accounts for both the Rasterizer's repeat_lines and band edges, and the index
+// of the band it came from.
+struct RunInfo {
+  Rasterizer::RasterInfo shape;
+  unsigned first_line;
+  unsigned line_count;
+  unsigned band;
+};
+static RunInfo working_run[lookahead_lines];
 
-// When a Rasterizer completes and updates the working buffer, we set this
-// flag.  This triggers a copy into the scan buffer at next hblank, at which
-// time the flag is cleared.  The copy is conditional because it isn't always
-// necessary, e.g. in rasterizer that use line-doubling, so we can save some
-// resources by eliding it.
+/*
+ * The lookahead ring is managed with two free-running counters.  The producer
+ * (rasterization, in hblank_work) fills the buffer at ring_tail % N and then
+ * advances ring_tail.  The consumer (end_of_active_video) copies the buffer at
+ * ring_head % N into the scan buffer and then advances ring_head.  The
+ * difference between them is the number of rasterized lines banked ahead of
+ * scanout.
+ *
+ * In zero-copy mode, the consumer leaves the buffer it's scanning out at the
+ * head of the ring, and only advances past it when taking the next run.
+ *
+ * Because the consumer runs at higher priority than the producer, a
+ * rasterizer that overruns its line doesn't delay scanout of lines already
+ * banked.
+ */
+static std::atomic<unsigned> ring_head;
+static std::atomic<unsigned> ring_tail;
+
+// The next visible line the producer will rasterize.  Producer-only, except at
+// the top of the frame.
+static unsigned produce_line;
+
+// The number of visible lines, counting from the top of the frame, that the
+// consumer has already set up for scanout.  It's too late to rasterize these,
+// so after an overrun the producer skips ahead to this line rather than
+// rasterizing lines that can only be discarded.  Written by the consumer.
+static std::atomic<unsigned> scanout_progress;
+
+// The pixels being scanned out, their shape, and how many more times they
+// should be scanned out after the current line.  Consumer-only.
+static Pixel const *scan_pixels;
+static Rasterizer::RasterInfo scan_shape;
+static unsigned scan_lines_left;
+
+// Index of the band the pixels being scanned out came from, for profiling.
+static unsigned volatile scan_band;
+
+// Lookahead statistics, maintained by the consumer.
+static LookaheadStats lookahead_stats;
+
+// The rasterizer time available per line, derived from the current Timing.
+static unsigned line_budget_cycles;
+
+// The time available to VblankJobs per frame, and a flag set by EAV at the
+// start of vertical blank to get them run.
+static unsigned vblank_budget_cycles;
+static bool volatile vblank_jobs_due;
+
+// Number of frames completed since configure_timing.  Incremented in the
+// first hblank of vertical blank, after the frame's statistics are published.
+static std::atomic<unsigned> frame_count;
+
+// Statistics for the frame in progress, and for the last two completed frames.
+// Completed frame n lives in frame_stats[n % 2], so that the application can
+// read the most recent one while the driver publishes the next.
 //
-// Since this is produced and consumed by interrupts running at a single
-// priority, it need not be volatile or atomic.
-static bool scan_buffer_needs_update;
-
-// A pre-built control register word to be used to start the next DMA transfer.
-// This is set up during hblank based on the working_buffer_shape, and consumed
-// at start of active video.
-static Dma::Stream::cr_value_t next_dma_xfer;
-IN_LOCAL_RAM
-static bool next_use_timer;
+// frame_accum is shared by EAV, which counts late and repeated lines, and the
+// lower-priority hblank work, which counts everything else.  EAV only counts
+// during active video, so hblank work publishes and resets the lot during
+// vertical blank; EAV just marks the end of the frame.
+static FrameStats frame_accum;
+static FrameStats frame_stats[2];
+static bool volatile frame_ended;
+static std::uint32_t frame_end_cycles;
+
+// What to scan out when a line isn't ready in time.
+static OverrunPolicy overrun_policy = OverrunPolicy::blank;
+
+// Per-band statistics.  The producer maintains everything but underruns, which
+// the consumer charges to the band the producer is working on at the time.
+static BandStats band_stats[max_monitored_bands];
+
+// Index of the band containing produce_line, counted from the head of the band
+// list.
+static unsigned volatile producing_band;
 
 // The head of the linked list of Rasterizer bands.
 static Band const *band_list_head;
 
-// A copy of the band we're currently processing.  We copy for several reasons:
-// - So that the application may keep its Bands in Flash without a latency
-//   penalty on the driver.
-// - So that we may mutate it, decrementing the line count.
-// - So that the application may rewrite its Bands once rendering starts.
-static Band current_band;
+/*
+ * The band list, compiled at the top of each frame into a table of runs of
+ * lines, so that the producer needn't chase pointers (possibly into Flash) or
+ * skip empty Bands mid-frame.  Each entry covers visible lines from the end of
+ * the previous entry up to (but not including) end_line, and is never empty.
+ * The final entry always ends at the bottom of the frame; if the band list
+ * falls short, it's padded with a blank entry.
+ *
+ * Because the schedule holds copies of the Bands' contents, the application may
+ * keep its Bands in Flash, and may rewrite them once rendering starts.
+ */
+struct ScheduleEntry {
+  Rasterizer *rasterizer;
+  unsigned end_line;
+  unsigned band;  // Position in the band list, for statistics.
+};
+IN_LOCAL_RAM
+static ScheduleEntry schedule[max_scheduled_bands + 1];
+
+// Index of the schedule entry containing produce_line.  Producer-only.
+static unsigned schedule_index;
+
+// Set at the top of each frame to ask the producer to recompile the schedule
+// before rasterizing.
+static bool volatile schedule_stale;
+
+// The CopperList configured by the application, if any.
+static CopperList *volatile copper_list;
+
+// Stands in for the copper list when there isn't one.
+static constexpr CopperOp copper_empty = CopperOp::end();
+
+// The next copper operation to run, in the current frame's copper list, and
+// the offset adjustment applied so far.  Producer-only.
+static CopperOp const *copper_next = &copper_empty;
+static int copper_offset;
+
+// Like band_list_taken, below, but for the copper list.
+static std::atomic<bool> copper_list_taken{false};
 
 // A semaphore used to indicate, to the application, when the driver has
 // begun processing the most recently configured band list.  Because the
-// driver maintains a copy of a Band, and this copy contains a pointer, it
-// is not safe to deallocate or repurpose a list of Bands while the driver
-// may be using them.  Instead, clear_band_list does it safely using this
-// semaphore.
+// driver's schedule contains pointers to the Rasterizers, it is not safe to
+// deallocate or repurpose a list of Bands (or their Rasterizers) while the
+// driver may be using them.  Instead, clear_band_list does it safely using
+// this semaphore.
 static std::atomic<bool> band_list_taken{false};
 
 
@@ -197,149 +291,43 @@ static std::atomic<bool> band_list_taken{false};
  */
 
 void init() {
-  // Turn on I/O compensation cell to reduce noise on power supply.
-  rcc.enable_clock(ApbPeripheral::syscfg);
-  syscfg.write_cmpcr(syscfg.read_cmpcr().with_cmp_pd(true));
-
-  // Turn a bunch of stuff on.
-  rcc.enable_clock(AhbPeripheral::gpiob);  // Sync signals
-  rcc.enable_clock(AhbPeripheral::gpioe);  // Video
-  rcc.enable_clock(AhbPeripheral::dma2);
-
-  auto &st = dma2.stream5;
-
-  // DMA configuration
-
-  // Configure FIFO.
-  st.write_fcr(Dma::Stream::fcr_value_t()
-               .with_fth(Dma::Stream::fcr_value_t::fth_t::quarter)
-               .with_dmdis(true)
-               .with_feie(false));
-
-  // Configure the pixel-generation timer used during reduced-horizontal mode.
-  // We use TIM1; it's an APB2 (fast) peripheral, and with our clock config
-  // it gets clocked at the full CPU rate.  We'll load ARR under rasterizer
-  // control to synthesize 1/n rates.
-  rcc.enable_clock(ApbPeripheral::tim1);
-  tim1.write_psc(1 - 1);  // Divide input clock by 1.
-  tim1.write_cr1(AdvTimer::cr1_value_t()
-      .with_urs(true));
-  tim1.write_dier(AdvTimer::dier_value_t()
-      .with_ude(true));  // DRQ on update
-
-  // Configure our interrupt priorities.  The scheme is:
-  //  TIM4 (horizontal) gets highest priority.
-  //  TIM3 (shock absorber) is set just lower.
-  //  PendSV (rendering, user code) is lowest.
-  // We could fit other stuff into the gaps later.
-  // Note that PendSV is set using ARMv7-M priorities (0-255) and the others are
-  // set using narrower SoC priorities (0-15).  This is a bit ugly.
-  set_irq_priority(Interrupt::tim4, 0);
-  set_irq_priority(Interrupt::tim3, 1);
-  scb.set_exception_priority(etl::armv7m::Exception::pend_sv, 0xFF);
-
-  // Halt all our timers on debug.
-  dbg.write_dbgmcu_apb1_fz(dbg.read_dbgmcu_apb1_fz()
-                           .with_dbg_tim4_stop(true)
-                           .with_dbg_tim3_stop(true));
-
-  dbg.write_dbgmcu_apb2_fz(dbg.read_dbgmcu_apb2_fz()
-                           .with_dbg_tim1_stop(true));
-
-  // Enable Flash cache and prefetching to try and reduce jitter.
-  // This only affects best-effort-level code, not anything realtime.
-  flash.write_acr(flash.read_acr()
-                  .with_dcen(true)
-                  .with_icen(true)
-                  .with_prften(true));
+  backend::init();
 
   band_list_head = nullptr;
   band_list_taken = false;
+  copper_list = nullptr;
+  copper_list_taken = false;
 
   sync_off();
   video_off();
   arena_reset();
 }
 
-void sync_off() {
-  gpiob.set_mode((1 << 6) | (1 << 7), Gpio::Mode::input);
-  gpiob.set_pull((1 << 6) | (1 << 7), Gpio::Pull::down);
-}
-
-void video_off() {
-  gpioe.set_mode(0xFF00, Gpio::Mode::input);
-  gpioe.set_pull(0xFF00, Gpio::Pull::down);
-}
-
-void sync_on() {
-  // Configure PB6 to produce hsync using TIM4_CH1
-  gpiob.set_alternate_function(Gpio::p6, 2);
-  gpiob.set_output_type(Gpio::p6, Gpio::OutputType::push_pull);
-  gpiob.set_output_speed(Gpio::p6, Gpio::OutputSpeed::fast_50mhz);
-  gpiob.set_mode(Gpio::p6, Gpio::Mode::alternate);
-
-  // Configure PB7 as GPIO output.
-  gpiob.set_output_type(Gpio::p7, Gpio::OutputType::push_pull);
-  gpiob.set_output_speed(Gpio::p7, Gpio::OutputSpeed::fast_50mhz);
-  gpiob.set_mode(Gpio::p7, Gpio::Mode::gpio);
-}
-
-void video_on() {
-  // Configure the high byte of port E for parallel video.
-  // Using 100MHz output speed gets slightly sharper transitions than 50MHz.
-  gpioe.set_output_type(0xFF00, Gpio::OutputType::push_pull);
-  gpioe.set_output_speed(0xFF00, Gpio::OutputSpeed::high_100mhz);
-  gpioe.set_mode(0xFF00, Gpio::Mode::gpio);
-}
-
 /*
- * Sets up one of the two horizontal timers, which share almost all of their
- * init code.
+ * Profiling helpers.  These compile to nothing unless VGA_PROFILE is defined.
  */
-static void configure_h_timer(Timing const &timing,
-                              ApbPeripheral p,
-                              GpTimer &tim) {
-  rcc.enable_clock(p);
-  rcc.leave_reset(p);
-
-  // Configure the timer to count in pixels.  These timers live on APB1.
-  // Like all APB timers they get their clocks doubled at certain APB
-  // multipliers.
-  auto apb_cycles_per_pixel = timing.clock_config.apb1_divisor > 1
-      ? (timing.cycles_per_pixel * 2 / timing.clock_config.apb1_divisor)
-      : timing.cycles_per_pixel;
-
-  tim.write_psc(apb_cycles_per_pixel - 1);
-
-  tim.write_arr(timing.line_pixels - 1);
-  tim.write_ccr1(timing.sync_pixels);
-  tim.write_ccr2(timing.sync_pixels
-                 + timing.back_porch_pixels - timing.video_lead);
-  tim.write_ccr3(timing.sync_pixels
-                 + timing.back_porch_pixels + timing.video_pixels);
-
-  tim.write_ccmr1(GpTimer::ccmr1_value_t()
-                  .with_oc1m(GpTimer::OcMode::pwm1)
-                  .with_cc1s(GpTimer::ccmr1_value_t::cc1s_t::output));
-
-  tim.write_ccer(GpTimer::ccer_value_t()
-                 .with_cc1e(true)
-                 .with_cc1p(
-                     timing.hsync_polarity == Timing::Polarity::negative));
+ETL_INLINE static std::uint32_t profile_start() {
+  return profile::enabled ? backend::cycle_count() : 0;
+}
 
+ETL_INLINE static void profile_finish(profile::Probe probe,
+                                      unsigned band,
+                                      std::uint32_t start) {
+  if (profile::enabled) {
+    profile::record(probe, band, backend::cycle_count() - start);
+  }
 }
 
 /*
- * Safely shut down a timer, so that we can reconfigure without interlocks.
+ * Returns the shape of a blank line in the current mode.
  */
-static void disable_h_timer(ApbPeripheral p,
-                            Interrupt irq) {
-  // Ensure that we'll receive no further interrupts.
-  disable_irq(irq);
-  // Ensure that the peripheral will generate no further interrupts.
-  rcc.enter_reset(p);
-  // In case of race condition between the above actions, clear any pending.
-  clear_pending_irq(irq);
+static Rasterizer::RasterInfo blank_line_shape() {
+  return {
+    .offset = 0,
+    .length = 0,
+    .cycles_per_pixel = current_timing.cycles_per_pixel,
+    .repeat_lines = 0,
+  };
 }
 
 void configure_timing(Timing const &timing) {
@@ -347,87 +335,50 @@ void configure_timing(Timing const &timing) {
   sync_off();
   video_off();
 
-  // Place the horizontal timers in reset, disabling interrupts.
-  disable_h_timer(ApbPeripheral::tim4, Interrupt::tim4);
-  disable_h_timer(ApbPeripheral::tim3, Interrupt::tim3);
-
-  // Busy-wait for pending DMA to complete.
-  while (dma2.stream5.read_cr().get_en());
-
-  // No scanout strategy can achieve fewer than 4 cycles per pixel.
-  ETL_ASSERT(timing.cycles_per_pixel >= 4);
-  // Because horizontal timing is managed by timers on the slower APB1 bus,
-  // make sure that we can express the (AHB) cycles_per_pixel in APB1 units.
-  if (timing.clock_config.apb1_divisor > 1) {
-    ETL_ASSERT(timing.cycles_per_pixel % (timing.clock_config.apb1_divisor / 2)
-                  == 0);
-  }
-
-  // Switch to new CPU clock settings.
-  rcc.configure_clocks(timing.clock_config);
-
-  // Configure TIM3/4 for horizontal sync generation.
-  configure_h_timer(timing, ApbPeripheral::tim3, tim3);
-  configure_h_timer(timing, ApbPeripheral::tim4, tim4);
-
-  // Adjust tim3's CC2 value back in time.
-  tim3.write_ccr2(Word(tim3.read_ccr2()) - shock_absorber_shift_cycles);
+  // Stop the line clock so that no events arrive while we rearrange things.
+  backend::stop_timing();
+  backend::configure_timing(timing);
 
-  // Configure tim3 to distribute its enable signal as its trigger output.
-  tim3.write_cr2(GpTimer::cr2_value_t()
-                 .with_mms(GpTimer::cr2_value_t::mms_t::enable)
-                 .with_ccds(false));
-
-  // Configure tim4 to trigger from tim3 and run forever.
-  tim4.write_smcr(GpTimer::smcr_value_t()
-                  .with_ts(GpTimer::smcr_value_t::ts_t::itr2)
-                  .with_sms(GpTimer::smcr_value_t::sms_t::trigger));
-
-  // Turn on tim4's interrupts.
-  tim4.write_dier(GpTimer::dier_value_t()
-                  .with_cc2ie(true)    // Interrupt at start of active video.
-                  .with_cc3ie(true));  // Interrupt at end of active video.
-
-  // Turn on only one of tim3's
-  tim3.write_dier(GpTimer::dier_value_t()
-                  .with_cc2ie(true));  // Interrupt at start of active video.
-
-  // Note: timers still not running.
-
-  switch (timing.vsync_polarity) {
-    case Timing::Polarity::positive: gpiob.clear(1 << 7); break;
-    case Timing::Polarity::negative: gpiob.set  (1 << 7); break;
-  }
-
-  // Scribble over working buffer to help catch bugs.
-  for (size_t i = 0; i < sizeof(working.buffer); i += 2) {
-    working.buffer[i] = 0xFF;
-    working.buffer[i + 1] = 0x00;
+  // Scribble over working buffers to help catch bugs.
+  for (auto &w : working) {
+    for (size_t i = 0; i < sizeof(w.buffer); i += 2) {
+      w.buffer[i] = 0xFF;
+      w.buffer[i + 1] = 0x00;
+    }
   }
 
-  // Blank the final word of the scan buffer.
-  for (unsigned i = 0; i < sizeof(Word); ++i) {
-    scan_buffer[timing.video_pixels + i] = 0;
-  }
+  // Blank the stand-in for late lines.
+  for (auto &p : blank_pixels) p = 0;
 
   // Set up global state.
   current_line = 0;
   current_timing = timing;
   state = State::blank;
-  working_buffer_shape = {
-    .offset = 0,
-    .length = 0,
-    .cycles_per_pixel = timing.cycles_per_pixel,
-    .repeat_lines = 0,
-  };
-  next_use_timer = false;
-
-  scan_buffer_needs_update = false;
-
-  // Start TIM3, which starts TIM4.
-  enable_irq(Interrupt::tim3);
-  enable_irq(Interrupt::tim4);
-  tim3.write_cr1(tim3.read_cr1().with_cen(true));
+  scan_shape = blank_line_shape();
+  scan_pixels = blank_pixels;
+  scan_lines_left = 0;
+  ring_head = ring_tail = 0;
+  produce_line = 0;
+  scanout_progress = 0;
+  producing_band = 0;
+  line_budget_cycles = timing.line_pixels * timing.cycles_per_pixel;
+  // Jobs start in the hblank of line 0 and must be done before rasterization
+  // starts at video_start_line - 1.  Leave a line's slack.
+  vblank_budget_cycles = timing.video_start_line > 2
+    ? (timing.video_start_line - 2) * line_budget_cycles : 0;
+  vblank_jobs_due = false;
+
+  reset_lookahead_stats();
+  reset_band_stats();
+  reset_vblank_stats();
+
+  frame_count = 0;
+  frame_ended = false;
+  frame_accum = {};
+  frame_accum.hblank_min_cycles = ~0u;
+  frame_stats[0] = frame_stats[1] = {};
+
+  backend::start_timing();
 
   sync_on();
 }
@@ -439,11 +390,21 @@ void configure_band_list(Band const *head) {
 
 void clear_band_list() {
   configure_band_list(nullptr);
-  while (!band_list_taken) etl::armv7m::wait_for_interrupt();
+  while (!band_list_taken) backend::idle();
+}
+
+void configure_copper_list(CopperList *list) {
+  copper_list = list;
+  copper_list_taken = false;
+}
+
+void clear_copper_list() {
+  configure_copper_list(nullptr);
+  while (!copper_list_taken) backend::idle();
 }
 
 void wait_for_vblank() {
-  while (!in_vblank()) etl::armv7m::wait_for_interrupt();
+  while (!in_vblank()) backend::idle();
 }
 
 bool in_vblank() {
@@ -451,53 +412,258 @@ bool in_vblank() {
 }
 
 void sync_to_vblank() {
-  while (in_vblank()) etl::armv7m::wait_for_interrupt();
+  while (in_vblank()) backend::idle();
   wait_for_vblank();
 }
 
+unsigned get_frame_count() {
+  return frame_count.load(std::memory_order_acquire);
+}
+
+FrameStats get_frame_stats() {
+  // The driver only rewrites a slot a frame after publishing the other, so a
+  // copy is consistent unless the frame count changed while we took it.
+  unsigned n;
+  FrameStats copy;
+  do {
+    n = frame_count.load(std::memory_order_acquire);
+    copy = frame_stats[n % 2];
+  } while (frame_count.load(std::memory_order_acquire) != n);
+  return copy;
+}
+
+LookaheadStats get_lookahead_stats() {
+  return lookahead_stats;
+}
+
+void reset_lookahead_stats() {
+  lookahead_stats = {
+    .capacity = lookahead_lines,
+    .low_water = lookahead_lines,
+    .underruns = 0,
+    .lines_measured = 0,
+    .occupancy_total = 0,
+  };
+}
+
+void set_overrun_policy(OverrunPolicy policy) {
+  overrun_policy = policy;
+}
+
+BandStats get_band_stats(unsigned band_index) {
+  if (band_index >= max_monitored_bands) return {};
+  return band_stats[band_index];
+}
+
+void reset_band_stats() {
+  for (auto &s : band_stats) s = {};
+}
+
+unsigned get_line_budget_cycles() {
+  return line_budget_cycles;
+}
+
+
 /*******************************************************************************
- * Horizontal timing implementation.  See also the ISR, declared outside of
- * namespace vga toward the end of the file.
+ * Scanout interface.  These are implementation factors of end_of_active_video.
+ */
+
+#if !VGA_ZERO_COPY_SCANOUT
+/*
+ * Transfers the contents of a working buffer into the scan buffer.
  */
+RAM_CODE
+static void update_scan_buffer(unsigned index) {
+  auto const &shape = working_run[index].shape;
+
+  // Note that GCC can't see that we've aligned the buffers correctly, so we
+  // have to do a multi-cast dance. :-/
+  copy_words(
+      reinterpret_cast<Word const *>(
+        static_cast<void *>(working[index].buffer)),
+      reinterpret_cast<Word *>(
+        static_cast<void *>(scan_buffer)),
+      (shape.length + sizeof(Word) - 1) / sizeof(Word));
+  for (unsigned i = 0; i < sizeof(Word); ++i) {
+    scan_buffer[shape.length + i] = 0;
+  }
+}
+#endif
 
+/*
+ * Passes a line to the backend for scanout, with profiling.
+ */
 RAM_CODE
-static void start_of_active_video() {
+static void prepare_scanout(Pixel const *pixels,
+                            Rasterizer::RasterInfo const &shape) {
+  auto start = profile_start();
+  backend::prepare_scanout(pixels, shape);
+  profile_finish(profile::Probe::prepare_scanout, scan_band, start);
+}
+
+/*
+ * Handles a line that wasn't rasterized in time, by scanning out either
+ * nothing or a repeat of the line before, according to the overrun policy.
+ * Either is better than scanning out a half-finished line.
+ *
+ * 'first_stale' and 'head' are the ring positions before and after prepare_line
+ * discarded runs that ended before this line.
+ */
+RAM_CODE
+static void scan_out_late_line(unsigned first_stale, unsigned head) {
+  ++lookahead_stats.underruns;
+  ++frame_accum.lines_late;
+  lookahead_stats.low_water = 0;
+
+  unsigned band = producing_band;
+  if (band < max_monitored_bands) ++band_stats[band].underruns;
+
+  if (overrun_policy == OverrunPolicy::repeat) {
+#if VGA_ZERO_COPY_SCANOUT
+    // The most recently displayed line lives in the last run we discarded.
+    // Keep it out of the producer's reach and scan it out again.  This holds
+    // its buffer for one line only: being stale, it's discarded by the next
+    // prepare_line, and meanwhile the producer has the rest of the ring.
+    if (head != first_stale) {
+      --head;
+      unsigned index = head % lookahead_lines;
+      scan_pixels = working[index].buffer;
+      scan_shape = working_run[index].shape;
+      scan_band = working_run[index].band;
+      ring_head.store(head, std::memory_order_release);
+      prepare_scanout(scan_pixels, scan_shape);
+      return;
+    }
+#else
+    (void) first_stale;  // Only needed in zero-copy mode.
+
+    // The scan buffer still holds the most recently displayed line.
+    ring_head.store(head, std::memory_order_release);
+    prepare_scanout(scan_pixels, scan_shape);
+    return;
+#endif
+  }
+
+  ring_head.store(head, std::memory_order_release);
+  prepare_scanout(blank_pixels, blank_line_shape());
+}
+
+/*
+ * Arranges for the given visible line to be scanned out at the next SAV.
+ */
+RAM_CODE
+static void prepare_line(unsigned visible_line) {
+  scanout_progress.store(visible_line + 1, std::memory_order_relaxed);
+
+  if (scan_lines_left) {
+    // Repeating the line already being scanned out.  The scanout machinery
+    // still needs to be rearmed.
+    --scan_lines_left;
+    ++frame_accum.lines_repeated;
+    prepare_scanout(scan_pixels, scan_shape);
+    return;
+  }
+
+  unsigned const first_stale = ring_head.load(std::memory_order_relaxed);
+  unsigned head = first_stale;
+  unsigned tail = ring_tail.load(std::memory_order_acquire);
+
+  // Discard any runs that ended before this line.  This happens if the
+  // producer has fallen behind, and, in zero-copy mode, to the run we were
+  // scanning out until now.
+  while (head != tail) {
+    auto const &run = working_run[head % lookahead_lines];
+    if (run.first_line + run.line_count > visible_line) break;
+    ++head;
+  }
+
+  if (ETL_UNLIKELY(head == tail
+        || working_run[head % lookahead_lines].first_line > visible_line)) {
+    // The line isn't ready.
+    scan_out_late_line(first_stale, head);
+    return;
+  }
+
+  // Record occupancy, except toward the bottom of the frame, where the ring
+  // drains because the producer has run out of lines, not time.
+  auto const &last = working_run[(tail - 1) % lookahead_lines];
+  if (last.first_line + last.line_count
+      < unsigned(current_timing.video_end_line
+                 - current_timing.video_start_line)) {
+    unsigned ready = tail - head;
+    if (ready < lookahead_stats.low_water) lookahead_stats.low_water = ready;
+    lookahead_stats.occupancy_total += ready;
+    ++lookahead_stats.lines_measured;
+  }
+
+  unsigned index = head % lookahead_lines;
+  auto const &run = working_run[index];
+  scan_shape = run.shape;
+  scan_lines_left = run.first_line + run.line_count - 1 - visible_line;
+  scan_band = run.band;
+
+#if VGA_ZERO_COPY_SCANOUT
+  // Scan out of the working buffer in place.  It stays at the head of the ring,
+  // out of the producer's reach, until we move on.
+  scan_pixels = working[index].buffer;
+  ring_head.store(head, std::memory_order_release);
+#else
+  auto start = profile_start();
+  update_scan_buffer(index);
+  profile_finish(profile::Probe::update_scan_buffer, scan_band, start);
+  scan_pixels = scan_buffer;
+
+  // Hand the working buffer back to the producer.
+  ring_head.store(head + 1, std::memory_order_release);
+#endif
+
+  prepare_scanout(scan_pixels, scan_shape);
+}
+
+
+/*
+ * Publishes the statistics for the frame just completed and starts the next.
+ * Called from hblank work at the start of vertical blank.
+ */
+RAM_CODE
+static void publish_frame_stats() {
+  unsigned n = frame_count.load(std::memory_order_relaxed) + 1;
+
+  frame_accum.frame = n;
+  frame_accum.vblank_start_cycles = frame_end_cycles;
+  if (frame_accum.hblank_count == 0) frame_accum.hblank_min_cycles = 0;
+  frame_stats[n % 2] = frame_accum;
+  frame_count.store(n, std::memory_order_release);
+
+  frame_accum = {};
+  frame_accum.hblank_min_cycles = ~0u;
+}
+
+
+/*******************************************************************************
+ * Horizontal timing implementation.  The backend calls these at the
+ * corresponding points in each line; see backend.h.
+ */
+
+RAM_CODE
+void start_of_active_video() {
   // The start-of-active-video (SAV) event is only significant during visible
   // lines.
   if (ETL_UNLIKELY(!is_displayed_state(state))) return;
 
-  // Clear stream 5 flags (hifcr is a write-1-to-clear register).
-  dma2.write_hifcr(Dma::hifcr_value_t()
-                   .with_cdmeif5(true)
-                   .with_cteif5(true)
-                   .with_chtif5(true)
-                   .with_ctcif5(true));
-
-  // Start the countdown for first DRQ.
-  tim1.write_cr1(AdvTimer::cr1_value_t()
-      .with_urs(true)
-      .with_cen(next_use_timer));
-
-  dma2.stream5.write_cr(next_dma_xfer);
+  backend::start_scanout();
 }
 
 RAM_CODE
-static void end_of_active_video() {
+void end_of_active_video() {
   // The end-of-active-video (EAV) event is always significant, as it advances
-  // the line state machine and kicks off PendSV.
-
-  // Shut off TIM1; only really matters in reduced-horizontal mode.
-  tim1.write_cr1(AdvTimer::cr1_value_t()
-      .with_urs(true)
-      .with_cen(false));
+  // the line state machine and kicks off hblank work.
 
-  // Apply timing changes requested by the last rasterizer.
-  tim4.write_ccr2(current_timing.sync_pixels
-                  + current_timing.back_porch_pixels - current_timing.video_lead
-                  + working_buffer_shape.offset);
+  // Stop scanout of the line just finished.
+  backend::end_scanout();
 
-  // Pend a PendSV to process hblank tasks.
-  scb.write_icsr(Scb::icsr_value_t().with_pendsvset(true));
+  // Pend hblank work.
+  backend::pend_hblank_work();
 
   // We've finished this line; figure out what to do on the next one.
   unsigned next_line = current_line + 1;
@@ -505,19 +671,26 @@ static void end_of_active_video() {
   if (next_line == current_timing.vsync_start_line
       || next_line == current_timing.vsync_end_line) {
     // Either edge of vsync pulse.
-    gpiob.toggle(Gpio::p7);
+    backend::toggle_vsync();
   } else if (next_line == uint16_t(current_timing.video_start_line - 1)) {
     // We're one line before scanout begins -- need to start rasterizing.
     state = State::starting;
-    if (band_list_head) {
-      current_band = *band_list_head;
-    } else {
-      current_band = { nullptr, 0, nullptr };
-    }
-    band_list_taken = true;
+
+    // Start the frame with an empty ring.  The producer is idle during
+    // vertical blank, so we can safely reset its state too.
+    schedule_stale = true;
+    produce_line = 0;
+    scanout_progress.store(0, std::memory_order_relaxed);
+    producing_band = 0;
+    scan_band = 0;
+    scan_pixels = blank_pixels;
+    scan_shape = blank_line_shape();
+    scan_lines_left = 0;
+    ring_head.store(0, std::memory_order_relaxed);
+    ring_tail.store(0, std::memory_order_relaxed);
   } else if (next_line == current_timing.video_start_line) {
-    // Time to start output.  This will cause PendSV to copy rasterization
-    // output into place for scanout, and the next SAV will start DMA.
+    // Time to start output.  This will cause SAV to start DMA from lines
+    // taken out of the lookahead ring.
     state = State::active;
   } else if (next_line == uint16_t(current_timing.video_end_line - 1)) {
     // For the final line, suppress rasterization but continue preparing
@@ -525,12 +698,23 @@ static void end_of_active_video() {
     // SAV.
     state = State::finishing;
   } else if (next_line == uint16_t(current_timing.video_end_line)) {
-    // All done!  Suppress all scanout activity.
+    // All done!  Suppress all scanout activity, and get vblank work started.
     state = State::blank;
     next_line = 0;
+    vblank_jobs_due = true;
+    frame_end_cycles = backend::cycle_count();
+    frame_ended = true;
   }
 
   current_line = next_line;
+
+  // Set up scanout of the next line now, rather than in hblank_work, so that
+  // it can preempt a long-running rasterizer.  This writes to the scanout
+  // buffer *and* accesses AHB/APB peripherals, so it *cannot* run concurrently
+  // with scanout -- but here, we're at the very start of hblank.
+  if (ETL_LIKELY(is_displayed_state(state))) {
+    prepare_line(next_line - current_timing.video_start_line);
+  }
 }
 
 void default_hblank_interrupt();  // decl hack
@@ -538,243 +722,244 @@ RAM_CODE void default_hblank_interrupt() {}
 
 
 /*******************************************************************************
- * Rasterization interface.  These are implementation factors of the PendSV
- * ISR.
+ * Rasterization interface.  These are implementation factors of hblank_work.
  */
 
 /*
- * Advances the current rasterizer band, possibly switching it for the next if
- * we've reached the end.  The 'edge' parameter is used only in the recursive
- * case.  (It would not appear at all if this language had nested functions.)
+ * Compiles the band list into the schedule, clipping it to the visible lines in
+ * the current mode.  Empty Bands are dropped; Bands beyond the capacity of the
+ * schedule are treated as blank.
  */
-RAM_CODE
-static bool advance_rasterizer_band(bool edge = false) {
-  if (current_band.line_count) {
-    --current_band.line_count;
-    return edge;
+static void compile_schedule() {
+  unsigned visible_lines =
+    current_timing.video_end_line - current_timing.video_start_line;
+
+  unsigned count = 0;
+  unsigned line = 0;
+  unsigned band = 0;
+  for (Band const *b = band_list_head;
+       b && line < visible_lines && count < max_scheduled_bands;
+       b = b->next, ++band) {
+    if (b->line_count == 0) continue;
+
+    unsigned lines = b->line_count;
+    if (lines > visible_lines - line) lines = visible_lines - line;
+    line += lines;
+    schedule[count++] = { b->rasterizer, line, band };
   }
 
-  if (current_band.next) {
-    current_band = *current_band.next;
-    return advance_rasterizer_band(true);
-  } else {
-    current_band = { nullptr, 0, nullptr };
-    return edge;
+  if (line < visible_lines) {
+    schedule[count++] = { nullptr, visible_lines, band };
   }
+
+  band_list_taken = true;
+  schedule_index = 0;
+  producing_band = schedule[0].band;
 }
 
 /*
- * Transfers the contents of the working buffer into the scan buffer, if
- * necessary.
+ * Picks up the copper list for the new frame.
  */
-RAM_CODE
-static void update_scan_buffer() {
-  if (scan_buffer_needs_update) {
-    // Flip working_buffer into scan_buffer.  We know its contents are ready
-    // because of the scan_buffer_needs_update flag.  Note that the flag may
-    // not have been set, even in a displayed state, if we're repeating a
-    // line.
-    //
-    // Note that GCC can't see that we've aligned the buffers correctly, so we
-    // have to do a multi-cast dance. :-/
-    copy_words(
-        reinterpret_cast<Word const *>(
-          static_cast<void *>(working.buffer)),
-        reinterpret_cast<Word *>(
-          static_cast<void *>(scan_buffer)),
-        (working_buffer_shape.length + sizeof(Word) - 1) / sizeof(Word));
-    for (unsigned i = 0; i < sizeof(Word); ++i) {
-      scan_buffer[working_buffer_shape.length + i] = 0;
-    }
-    scan_buffer_needs_update = false;
-  }
+static void start_copper_list() {
+  auto list = copper_list;
+  copper_next = list ? list->begin_frame() : &copper_empty;
+  copper_offset = 0;
+  copper_list_taken = true;
 }
 
 /*
- * Prepares a configuration for the DMA stream and configures the horizontal
- * timer, if it's relevant to this mode.
+ * Runs any copper operations due before produce_line is rasterized.  If the
+ * producer skipped lines, operations due on them run late rather than not at
+ * all, so that later lines see their effects.
  */
 RAM_CODE
-static void prepare_for_scanout() {
-  auto & st = dma2.stream5;
-  st.write_cr(st.read_cr().with_en(false));
-
-  if (working_buffer_shape.cycles_per_pixel > 4) {
-    // Adjust reload frequency of TIM1 to accomodate desired pixel clock.
-    // (ARR value is period - 1.)
-    tim1.write_arr(working_buffer_shape.cycles_per_pixel - 1);
-    // Force an update to reset the timer state.
-    tim1.write_egr(AdvTimer::egr_value_t().with_ug(true));
-    // Configure the timer as *almost* ready to produce a DRQ, less a small
-    // value (fudge factor).  Gotta do this after the update event, above,
-    // because that clears CNT.
-    tim1.write_cnt(uint32_t(tim1.read_arr()) - drq_shift_cycles);
-    tim1.write_sr(0);
-
-    st.write_par(0x40021015);  // High byte of GPIOE ODR (hack hack)
-    st.write_m0ar(reinterpret_cast<Word>(&scan_buffer));
-
-    // The number of bytes read must exactly match the number of bytes written,
-    // or the DMA controller will freak out.  Thus, we must adapt the transfer
-    // size to the number of bytes transferred.
-    Dma::Stream::TransferSize msize;
-    switch (working_buffer_shape.length & 3) {
-      case 0:
-        msize = Dma::Stream::TransferSize::word;
-        st.write_ndtr(working_buffer_shape.length + sizeof(Word));
-        break;
-
-      case 2:
-        msize = Dma::Stream::TransferSize::half_word;
-        st.write_ndtr(working_buffer_shape.length + sizeof(HalfWord));
+static void run_copper_ops() {
+  while (copper_next->line <= produce_line) {
+    auto const &op = *copper_next++;
+    switch (op.kind) {
+      case CopperOp::Kind::write_byte:
+        *static_cast<std::uint8_t *>(op.address) = std::uint8_t(op.value);
         break;
 
-      default:
-        msize = Dma::Stream::TransferSize::byte;
-        st.write_ndtr(working_buffer_shape.length + sizeof(Byte));
+      case CopperOp::Kind::write_word:
+        *static_cast<std::uint32_t *>(op.address) = op.value;
         break;
-    }
-
-    next_dma_xfer = dma_xfer_common
-        .with_dir(Dma::Stream::cr_value_t::dir_t::memory_to_peripheral)
-        .with_msize(msize)
-        .with_minc(true)
-        .with_psize(Dma::Stream::TransferSize::byte)
-        .with_pinc(false);
-    next_use_timer = true;
 
-  } else {
-    // Note that we're using memory as the peripheral side.
-    // This DMA controller is a little odd.
-    st.write_par(reinterpret_cast<Word>(&scan_buffer));
-    st.write_m0ar(0x40021015);  // High byte of GPIOE ODR (hack hack)
-
-    Dma::Stream::TransferSize psize;
-    switch (working_buffer_shape.length & 3) {
-      case 0:
-        psize = Dma::Stream::TransferSize::word;
-        st.write_ndtr(working_buffer_shape.length / sizeof(Word) + 1);
+      case CopperOp::Kind::call:
+        op.function(op.address);
         break;
 
-      case 2:
-        psize = Dma::Stream::TransferSize::half_word;
-        st.write_ndtr(working_buffer_shape.length / sizeof(HalfWord) + 1);
+      case CopperOp::Kind::set_offset:
+        copper_offset = int(op.value);
         break;
 
-      default:
-        psize = Dma::Stream::TransferSize::byte;
-        st.write_ndtr(working_buffer_shape.length / sizeof(Byte) + 1);
-        break;
+      case CopperOp::Kind::end:
+        // Unreachable: the end operation's line is never reached.
+        return;
     }
-
-    next_dma_xfer = dma_xfer_common
-        .with_dir(Dma::Stream::cr_value_t::dir_t::memory_to_memory)
-        .with_psize(psize)
-        .with_pinc(true)
-        .with_msize(Dma::Stream::TransferSize::byte)
-        .with_minc(false);
-    next_use_timer = false;
   }
 }
 
 /*
- * Generates pixels for the *next* line, not the currently displaying one.
+ * Rasterizes the next run of lines into the working buffer at the tail of the
+ * ring.  A run is the line at produce_line plus any repeats requested by the
+ * Rasterizer, cut short at the band edge.
  */
 RAM_CODE
-static void rasterize_next_line() {
+static void rasterize_next_run() {
   auto const &timing = current_timing;
-  auto next_line = current_line + 1;
-  auto visible_line = next_line - timing.video_start_line;
-
-  bool band_edge = advance_rasterizer_band();
-  if (working_buffer_shape.repeat_lines == 0 || band_edge) {
-    // Either the last rasterizer has run out of its repeat count and wants
-    // to be called again, or we've reached a band edge and are going to call
-    // the new rasterizer no matter what the old one wished.
-    auto r = current_band.rasterizer;
-    if (r) {
-      working_buffer_shape = r->rasterize(current_timing.cycles_per_pixel,
-                                          visible_line,
-                                          working.buffer);
-      // Request a rewrite of the scanout buffer during next hblank.
-    } else {
-      working_buffer_shape = {
-        .offset = 0,
-        .length = 0,
-        .cycles_per_pixel = current_timing.cycles_per_pixel,
-        .repeat_lines = 0,
-      };
+
+  // Runs never cross band edges, but the producer may have skipped lines, and
+  // with them whole entries.
+  if (produce_line >= schedule[schedule_index].end_line) {
+    do {
+      ++schedule_index;
+    } while (produce_line >= schedule[schedule_index].end_line);
+    producing_band = schedule[schedule_index].band;
+  }
+  auto const &entry = schedule[schedule_index];
+
+  run_copper_ops();
+
+  unsigned tail = ring_tail.load(std::memory_order_relaxed);
+  unsigned index = tail % lookahead_lines;
+  auto &run = working_run[index];
+
+  auto r = entry.rasterizer;
+  if (r) {
+    auto start = backend::cycle_count();
+    run.shape = r->rasterize(timing.cycles_per_pixel,
+                             produce_line,
+                             working[index].buffer);
+    auto cycles = backend::cycle_count() - start;
+    ++frame_accum.lines_rasterized;
+
+    // Note that this includes time spent in higher-priority interrupts.
+    unsigned band = producing_band;
+    if (profile::enabled) {
+      profile::record(profile::Probe::rasterize, band, cycles);
+    }
+    if (band < max_monitored_bands) {
+      auto &stats = band_stats[band];
+      ++stats.calls;
+      if (cycles > stats.worst_cycles) stats.worst_cycles = cycles;
+      if (cycles > line_budget_cycles) ++stats.overruns;
     }
-    scan_buffer_needs_update = true;
-  } else {  // repeat_lines > 0, not band_edge
-    --working_buffer_shape.repeat_lines;
+  } else {
+    run.shape = blank_line_shape();
   }
-}
 
-}  // namespace vga
+  // Follow the pixels with a blank word if they'll be scanned out in place.
+  for (unsigned i = 0; i < working_tail_pixels; ++i) {
+    working[index].buffer[run.shape.length + i] = 0;
+  }
 
+  // Either the rasterizer runs out of its repeat count and wants to be called
+  // again, or we reach a band edge and are going to call the new rasterizer no
+  // matter what the old one wished.
+  unsigned lines = run.shape.repeat_lines + 1;
+  if (lines > entry.end_line - produce_line) {
+    lines = entry.end_line - produce_line;
+  }
+  // Likewise, the run stops short of the next copper operation.
+  if (lines > copper_next->line - produce_line) {
+    lines = copper_next->line - produce_line;
+  }
 
-/*******************************************************************************
- * ISRs and user interrupt hook
- */
+  run.shape.offset += copper_offset;
 
-void vga_hblank_interrupt()
-  __attribute__((weak, alias("_ZN3vga24default_hblank_interruptEv")));
+  run.first_line = produce_line;
+  run.line_count = lines;
+  run.band = entry.band;
+  produce_line += lines;
 
-RAM_CODE void etl_stm32f4xx_tim3_handler() {
-  // We access this APB2 timer through the bridge on AHB1.  This implies
-  // both wait states and resource conflicts with scanout.  Get done fast.
-  tim3.write_sr(tim3.read_sr().with_cc2if(false));
+  // If the rasterizer overran, scanout may have passed the whole run while we
+  // worked.  Then it's of no use, and leaving it unpublished keeps its buffer
+  // free for lines that still are.
+  if (ETL_UNLIKELY(produce_line
+                   <= scanout_progress.load(std::memory_order_relaxed))) {
+    return;
+  }
 
-  // Idle the processor until preempted by any higher-priority interrupt.
-  // This ensures that the M4's D-code bus is available for exception entry.
-  // NOTE: this behaves correctly on the M4, but WFI is not guaranteed to
-  // actually do anything.
-  etl::armv7m::wait_for_interrupt();
+  // Publish the run to the consumer.
+  ring_tail.store(tail + 1, std::memory_order_release);
 }
 
-RAM_CODE void etl_stm32f4xx_tim4_handler() {
-  // We have to clear our interrupt flags, or this will recur.
-  auto sr = tim4.read_sr();
-
-  if (ETL_LIKELY(sr.get_cc2if())) {
-    tim4.write_sr(sr.with_cc2if(false));
-    vga::start_of_active_video();
-    return;
+/*
+ * Rasterizes lines ahead of scanout until the ring is full or we reach the
+ * end of the frame.
+ */
+RAM_CODE
+static void fill_lookahead_ring() {
+  if (schedule_stale) {
+    compile_schedule();
+    start_copper_list();
+    schedule_stale = false;
   }
 
-  if (sr.get_cc3if()) {
-    tim4.write_sr(sr.with_cc3if(false));
-    vga::end_of_active_video();
-    return;
+  unsigned visible_lines =
+    current_timing.video_end_line - current_timing.video_start_line;
+
+  while (true) {
+    // Skip any lines that scanout has already passed, so that one overrun
+    // costs the lines it overlapped and no more.
+    unsigned progress = scanout_progress.load(std::memory_order_relaxed);
+    if (ETL_UNLIKELY(produce_line < progress)) produce_line = progress;
+
+    if (produce_line >= visible_lines
+        || ring_tail.load(std::memory_order_relaxed)
+           - ring_head.load(std::memory_order_acquire) >= lookahead_lines) {
+      break;
+    }
+
+    rasterize_next_run();
   }
 }
 
 RAM_CODE
-void etl_armv7m_pend_sv_handler() {
-  // PendSV event is triggered shortly after EAV to process lower-priority
-  // tasks.
-
-  // First, prepare for scanout from SAV on this line.  This has two purposes:
-  // it frees up the rasterization target buffer so that we can overwrite it,
-  // and it applies pixel timing choices from the *last* rasterizer run to the
-  // scanout machine so that we can replace them as well.
-  //
-  // This writes to the scanout buffer *and* accesses AHB/APB peripherals, so it
-  // *cannot* run concurrently with scanout -- so we do it first, during hblank.
-  if (ETL_LIKELY(is_displayed_state(vga::state))) {
-    vga::update_scan_buffer();
-    vga::prepare_for_scanout();
+void hblank_work() {
+  // Hblank work is triggered shortly after EAV to process lower-priority
+  // tasks.  Scanout for this line was already set up at EAV.
+  auto hblank_start = backend::cycle_count();
+
+  if (ETL_UNLIKELY(frame_ended)) {
+    frame_ended = false;
+    publish_frame_stats();
   }
 
   // Allow the application to do additional work during what's left of hblank.
+  auto start = profile_start();
   vga_hblank_interrupt();
+  profile_finish(profile::Probe::hblank_hook, scan_band, start);
 
-  // Second, rasterize the *next* line, if there's a useful next line.
+  // Rasterize upcoming lines, if there are useful upcoming lines.
   // Rasterization can take a while, and may run concurrently with scanout.
-  // As a result, we just stash our results in places where the *next* PendSV
+  // As a result, we just stash our results in the lookahead ring, where EAV
   // will find and apply them.
-  if (ETL_LIKELY(is_rendered_state(vga::state))) {
-    vga::rasterize_next_line();
+  if (ETL_LIKELY(is_rendered_state(state))) {
+    fill_lookahead_ring();
+  } else if (vblank_jobs_due) {
+    vblank_jobs_due = false;
+    run_vblank_jobs(vblank_budget_cycles);
   }
+
+  unsigned cycles = backend::cycle_count() - hblank_start;
+  if (cycles < frame_accum.hblank_min_cycles) {
+    frame_accum.hblank_min_cycles = cycles;
+  }
+  if (cycles > frame_accum.hblank_max_cycles) {
+    frame_accum.hblank_max_cycles = cycles;
+  }
+  frame_accum.hblank_total_cycles += cycles;
+  ++frame_accum.hblank_count;
 }
+
+}  // namespace vga
+
+
+/*******************************************************************************
+ * User interrupt hook
+ */
+
+void vga_hblank_interrupt()
+  __attribute__((weak, alias("_ZN3vga24default_hblank_interruptEv")));
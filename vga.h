@@ -8,6 +8,7 @@ namespace vga {
 // Forward declarations of types used below.
 struct Timing;      // see: timing.h
 class Rasterizer;   // see: rasterizer.h
+class CopperList;   // see: copper.h
 
 
 /*******************************************************************************
@@ -29,6 +30,77 @@ struct Band {
   Band const *next;         // Where to go from here.
 };
 
+/*
+ * Statistics about the rasterization lookahead ring, for choosing a value of
+ * VGA_LOOKAHEAD_LINES.  "Occupancy" is the number of working buffers holding
+ * rasterized lines, measured as each is taken for scanout; it includes the
+ * buffer being taken.  It isn't measured once the last line of the frame has
+ * been rasterized.
+ *
+ * With VGA_ZERO_COPY_SCANOUT, the buffer being scanned out occupies a slot in
+ * the ring, so occupancy can't exceed capacity - 1.
+ */
+struct LookaheadStats {
+  unsigned capacity;              // VGA_LOOKAHEAD_LINES.
+  unsigned low_water;             // Smallest occupancy seen; 0 on underrun.
+  unsigned underruns;             // Lines blanked because they weren't ready.
+  unsigned lines_measured;        // Number of occupancy measurements.
+  std::uint64_t occupancy_total;  // Sum of occupancy, for averaging.
+};
+
+
+/*
+ * Statistics for one complete frame, from the start of one vertical blank to
+ * the start of the next.  Cycle counts are from the same cycle counter as the
+ * profiling and deadline statistics.
+ */
+struct FrameStats {
+  unsigned frame;                     // Frame number; see get_frame_count.
+  std::uint32_t vblank_start_cycles;  // Cycle count at the end of the frame.
+
+  // Duration of hblank work (the PendSV handler) on each line, including the
+  // application's vga_hblank_interrupt, rasterization, and VblankJobs.
+  unsigned hblank_min_cycles;
+  unsigned hblank_max_cycles;
+  std::uint64_t hblank_total_cycles;
+  unsigned hblank_count;
+
+  unsigned lines_rasterized;  // Calls to Rasterizers.
+  unsigned lines_repeated;    // Lines displayed again at a Rasterizer's request.
+  unsigned lines_late;        // Lines not ready in time; see OverrunPolicy.
+};
+
+/*
+ * What the driver scans out in place of a line that wasn't rasterized in time.
+ */
+enum class OverrunPolicy {
+  blank,    // Output black.  (Default.)
+  repeat,   // Output the previous line again.
+};
+
+/*
+ * Deadline statistics for one Band, identified by its position in the band
+ * list.  Cycle counts cover only the Rasterizer, but include any interrupts
+ * that preempt it.
+ */
+struct BandStats {
+  unsigned calls;         // Calls to rasterize.
+  unsigned worst_cycles;  // Longest call to rasterize.
+  unsigned overruns;      // Calls longer than get_line_budget_cycles().
+  unsigned underruns;     // Lines not ready in time while in this band.
+};
+
+/*
+ * Only this many Bands, from the head of the list, are monitored.
+ */
+constexpr unsigned max_monitored_bands = 16;
+
+/*
+ * Only this many non-empty Bands, from the head of the list, are displayed.
+ * Lines described by Bands past this point are blank.
+ */
+constexpr unsigned max_scheduled_bands = 32;
+
 
 /*******************************************************************************
  * Public functions
@@ -51,8 +123,11 @@ void init();
  * produce pixels for an entire screen.  Once provided, this list will be reused
  * until replaced or cleared.
  *
- * It's safe to alter the Bands during the vertical blanking interval.  Changes
- * made during active video may or may not be reflected.
+ * The driver reads the list once per frame, one line before active video
+ * begins, so it's safe to alter the Bands at any other time; changes take
+ * effect at the next frame.  Bands with a line_count of zero are skipped, and
+ * line counts beyond the bottom of the screen are ignored.  If the list is too
+ * short to cover the screen, the remaining lines are blank.
  *
  * Remember to take the Band pointer back (typically using clear_band_list)
  * before deallocating the Band or Rasterizers!
@@ -66,6 +141,22 @@ void configure_band_list(Band const *head);
  */
 void clear_band_list();
 
+/*
+ * Provides the driver with a CopperList, whose foreground page will be executed
+ * each frame from the next frame on.  Passing nullptr disables copper
+ * operations from the next frame.
+ *
+ * Remember to take the CopperList back (using clear_copper_list) before
+ * discarding it!
+ */
+void configure_copper_list(CopperList *);
+
+/*
+ * Switches the driver's copper list for none, and synchronizes with the driver
+ * to ensure that the change has been made.
+ */
+void clear_copper_list();
+
 /*
  * Configures vertical and horizontal timing according to the parameters
  * contained in the given Timing struct.  Note that this will also change the
@@ -108,6 +199,65 @@ void sync_to_vblank();
  */
 bool in_vblank();
 
+/*
+ * Returns the number of frames completed since configure_timing.  This
+ * advances at the start of each vertical blank, so it's handy for pacing
+ * animation.
+ */
+unsigned get_frame_count();
+
+/*
+ * Returns statistics for the most recently completed frame.  This is safe to
+ * call at any time, from any context but an interrupt that preempts the
+ * driver, and never blocks the driver.
+ */
+FrameStats get_frame_stats();
+
+/*
+ * Returns the lookahead ring statistics accumulated since the last call to
+ * configure_timing or reset_lookahead_stats.
+ *
+ * A low_water mark that stays above 1 means VGA_LOOKAHEAD_LINES could be
+ * reduced to save RAM; underruns mean some rasterizer can't keep up even with
+ * the lookahead available.
+ */
+LookaheadStats get_lookahead_stats();
+
+/*
+ * Zeroes the lookahead ring statistics.
+ */
+void reset_lookahead_stats();
+
+/*
+ * Chooses what to scan out when a Rasterizer misses its deadline; see
+ * OverrunPolicy.  Repeating the previous line is usually less visible than a
+ * black line for photographic content, and more visible for text.
+ */
+void set_overrun_policy(OverrunPolicy);
+
+/*
+ * Returns the deadline statistics for the Band at the given position in the
+ * band list (0 for the head) accumulated since the last call to
+ * configure_timing or reset_band_stats.  Positions at or beyond
+ * max_monitored_bands read as zero.
+ *
+ * Because the band list can change between frames, the statistics follow the
+ * position, not the Band.
+ */
+BandStats get_band_stats(unsigned band_index);
+
+/*
+ * Zeroes the statistics for all Bands.
+ */
+void reset_band_stats();
+
+/*
+ * Returns the duration of one line in the current mode, in CPU cycles.  A
+ * Rasterizer that routinely takes longer than this will eventually fall
+ * behind, however deep the lookahead ring.
+ */
+unsigned get_line_budget_cycles();
+
 /*
  * Switches on the parallel output leading to the video DAC.  It's best to do
  * this during vertical blank, once you're ready to produce a frame.